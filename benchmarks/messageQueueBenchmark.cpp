@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include "message.h"
+
+/// @brief The mutex guarded queue MessageQueue replaced, kept here as the baseline. Holds the current Message type so only the queue differs
+class MutexMessageQueue{
+public:
+    /// @brief Adds a message to the queue
+    /// @param message The message to add
+    void push(const Message& message){
+        //Lock the queue with the mutex for thread safety
+        std::lock_guard<std::mutex> lock(mutex);
+
+        //Push the message into the queue
+        queue.push(message);
+    }
+
+    /// @brief Removes the oldest message
+    /// @param output Message to write to
+    /// @return False if the queue was empty
+    bool tryPop(Message& output){
+        //Lock the queue with the mutex for thread safety
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if(queue.empty())
+            return false;
+
+        output = queue.front();
+        queue.pop();
+        return true;
+    }
+
+private:
+    std::queue<Message> queue;
+    std::mutex mutex;
+};
+
+/// @brief Result of a single benchmark run
+struct BenchmarkResult{
+    double seconds;
+    //Sum of the payloads received, checked against the sum sent
+    uint64_t checksum;
+};
+
+/// @brief Starts producers that each post a run of messages while the calling thread consumes them all
+/// @param producerCount Number of producer threads
+/// @param messagesPerProducer Number of messages each producer posts
+/// @param push Called by the producers to post a message
+/// @param tryPop Called by the consumer to take a message
+/// @return
+template<typename PushFunc, typename PopFunc>
+static BenchmarkResult runContention(uint32_t producerCount, uint64_t messagesPerProducer, PushFunc push, PopFunc tryPop){
+    std::atomic<bool> start(false);
+    std::vector<std::thread> producers;
+    for(uint32_t producer = 0; producer < producerCount; producer++){
+        producers.emplace_back([&, producer](){
+            while(!start.load(std::memory_order_acquire))
+                std::this_thread::yield();
+
+            AssetDecodedPayload payload{nullptr, nullptr, false, 0};
+            for(uint64_t idx = 0; idx < messagesPerProducer; idx++){
+                payload.contentHash = producer * messagesPerProducer + idx;
+                push(Message::create(MessageType::MSG_MESH_DECODED, payload));
+            }
+        });
+    }
+
+    uint64_t total = producerCount * messagesPerProducer;
+    uint64_t received = 0;
+    BenchmarkResult result{0.0, 0};
+
+    auto startTime = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    Message message;
+    while(received < total){
+        if(tryPop(message)){
+            result.checksum += message.get<AssetDecodedPayload>().contentHash;
+            received++;
+        }
+        else
+            std::this_thread::yield();
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    for(auto& producer : producers)
+        producer.join();
+    return result;
+}
+
+int main(int argc, char** argv){
+    //Usage: MessageQueueBenchmark [messages per producer]
+    uint64_t messagesPerProducer = argc > 1 ? strtoull(argv[1], nullptr, 10) : (1 << 20);
+    if(messagesPerProducer == 0)
+        messagesPerProducer = 1;
+
+    //Producer counts up to one per hardware thread, the consumer being the main thread
+    std::vector<uint32_t> producerCounts = {1, 2, 4, 8};
+    uint32_t hardwareThreads = std::thread::hardware_concurrency();
+    if(hardwareThreads > 1 && std::find(producerCounts.begin(), producerCounts.end(), hardwareThreads - 1) == producerCounts.end())
+        producerCounts.push_back(hardwareThreads - 1);
+    std::sort(producerCounts.begin(), producerCounts.end());
+
+    printf("%llu messages per producer, %u hardware threads\n", static_cast<unsigned long long>(messagesPerProducer), hardwareThreads);
+    printf("%-10s %-8s %12s %14s %10s %12s\n", "queue", "threads", "ms", "messages/s", "rejected", "peak depth");
+
+    bool valid = true;
+    for(uint32_t producerCount : producerCounts){
+        uint64_t total = producerCount * messagesPerProducer;
+        uint64_t expectedChecksum = total * (total - 1) / 2;
+
+        MutexMessageQueue mutexQueue;
+        BenchmarkResult mutexResult = runContention(producerCount, messagesPerProducer,
+            [&](const Message& message){ mutexQueue.push(message); },
+            [&](Message& message){ return mutexQueue.tryPop(message); });
+        printf("%-10s %-8u %12.2f %14.0f %10s %12s\n", "mutex", producerCount, mutexResult.seconds * 1000.0, total / mutexResult.seconds, "-", "-");
+
+        MessageQueue ringQueue;
+        ringQueue.setConsumerThread();
+        BenchmarkResult ringResult = runContention(producerCount, messagesPerProducer,
+            [&](const Message& message){ ringQueue.push(message); },
+            [&](Message& message){ return ringQueue.tryPop(message); });
+        MessageQueueStats stats = ringQueue.getStats();
+        printf("%-10s %-8u %12.2f %14.0f %10llu %12llu\n", "ring", producerCount, ringResult.seconds * 1000.0, total / ringResult.seconds,
+            static_cast<unsigned long long>(stats.rejected), static_cast<unsigned long long>(stats.peakDepth));
+
+        if(mutexResult.checksum != expectedChecksum || ringResult.checksum != expectedChecksum){
+            fprintf(stderr, "Checksum mismatch with %u producers\n", producerCount);
+            valid = false;
+        }
+    }
+
+    return valid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,153 @@
+#define TINYOBJLOADER_IMPLEMENTATION
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <tiny_obj_loader.h>
+#include "import_obj.h"
+#include "rendererData.h"
+
+/// @brief The tinyobj based importer that importModelFile replaced, kept here as the baseline
+/// @param modelPath The path of the model
+/// @return Returns the imported mesh with one vertex per face corner
+static Mesh* importModelFileTinyObj(const char* modelPath){
+    Mesh* mesh = new Mesh();
+
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string warn,err;
+
+    if(!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, modelPath)){
+        delete mesh;
+        throw std::runtime_error(warn + err);
+    }
+
+    std::vector<uint32_t> indices;
+    for(const auto& shape : shapes){
+        for(const auto& index : shape.mesh.indices){
+            Vertex vertex{};
+
+            vertex.position = {
+                attrib.vertices[3 * index.vertex_index + 0],
+                attrib.vertices[3 * index.vertex_index + 1],
+                attrib.vertices[3 * index.vertex_index + 2]
+            };
+
+            vertex.uv = {
+                attrib.texcoords[2 * index.texcoord_index + 0],
+                //Flip Y tex coord to match Y flip of renderer
+                1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
+            };
+
+            vertex.color = {1.0f, 1.0f, 1.0f};
+
+            mesh->vertices.push_back(vertex);
+            indices.push_back(static_cast<uint32_t>(indices.size()));
+        }
+    }
+    mesh->setIndices(indices);
+
+    return mesh;
+}
+
+/// @brief Writes a textured grid of quads to an OBJ file
+/// @param path The path of the file to write
+/// @param gridSize Number of quads along each side
+/// @return Returns the size of the written file in bytes
+static size_t writeGridObj(const std::string& path, uint32_t gridSize){
+    std::ofstream file(path, std::ios::binary);
+    if(!file.is_open())
+        throw std::runtime_error("Failed to create " + path);
+
+    char line[128];
+    for(uint32_t y = 0; y <= gridSize; y++){
+        for(uint32_t x = 0; x <= gridSize; x++){
+            float u = static_cast<float>(x) / gridSize;
+            float v = static_cast<float>(y) / gridSize;
+            int length = snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\n", u * 10.0f - 5.0f, 0.25f * u * v, v * 10.0f - 5.0f, u, v);
+            file.write(line, length);
+        }
+    }
+
+    //Quads are written as faces with four corners so both importers triangulate them
+    uint32_t rowSize = gridSize + 1;
+    for(uint32_t y = 0; y < gridSize; y++){
+        for(uint32_t x = 0; x < gridSize; x++){
+            uint32_t corner = y * rowSize + x + 1;
+            int length = snprintf(line, sizeof(line), "f %u/%u %u/%u %u/%u %u/%u\n",
+                corner, corner, corner + 1, corner + 1, corner + rowSize + 1, corner + rowSize + 1, corner + rowSize, corner + rowSize);
+            file.write(line, length);
+        }
+    }
+
+    return static_cast<size_t>(file.tellp());
+}
+
+/// @brief Imports the file repeatedly and prints the fastest run
+/// @param name Label printed with the result
+/// @param path The path of the model
+/// @param fileSize Size of the model file in bytes
+/// @param iterations Number of times the file is imported
+/// @param importer The importer to measure
+static void runBenchmark(const char* name, const std::string& path, size_t fileSize, int iterations, const std::function<Mesh*(const char*)>& importer){
+    double bestSeconds = 0.0;
+    size_t vertexCount = 0;
+    for(int iteration = 0; iteration < iterations; iteration++){
+        auto start = std::chrono::steady_clock::now();
+        Mesh* mesh = importer(path.c_str());
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        vertexCount = mesh->vertices.size();
+        delete mesh;
+        if(iteration == 0 || seconds < bestSeconds)
+            bestSeconds = seconds;
+    }
+
+    printf("%-24s %10.2f ms %10.1f MB/s %12zu vertices\n", name, bestSeconds * 1000.0, fileSize / (1024.0 * 1024.0) / bestSeconds, vertexCount);
+}
+
+int main(int argc, char** argv){
+    //Usage: ObjImportBenchmark [model.obj] [iterations]. A synthetic grid is generated when no model is given
+    std::string path = argc > 1 ? argv[1] : "objImportBenchmark.obj";
+    int iterations = argc > 2 ? atoi(argv[2]) : 5;
+    if(iterations < 1)
+        iterations = 1;
+
+    size_t fileSize;
+    try{
+        if(argc > 1){
+            std::ifstream file(path, std::ios::binary | std::ios::ate);
+            if(!file.is_open())
+                throw std::runtime_error("Failed to open " + path);
+            fileSize = static_cast<size_t>(file.tellg());
+        }
+        else
+            fileSize = writeGridObj(path, 512);
+
+        printf("%s: %.1f MB, best of %d\n", path.c_str(), fileSize / (1024.0 * 1024.0), iterations);
+
+        runBenchmark("tinyobj", path, fileSize, iterations, importModelFileTinyObj);
+        runBenchmark("chunked (serial)", path, fileSize, iterations, importModelFile);
+
+        JobSystem jobSystem;
+        jobSystem.initialize();
+        JobSystem::setActive(&jobSystem);
+        printf("Job system: %u workers\n", jobSystem.getWorkerCount());
+        runBenchmark("chunked (job system)", path, fileSize, iterations, importModelFile);
+        JobSystem::setActive(nullptr);
+        jobSystem.shutdown();
+    } catch(const std::exception& e){
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if(argc <= 1)
+        std::remove(path.c_str());
+    return EXIT_SUCCESS;
+}
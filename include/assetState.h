@@ -0,0 +1,12 @@
+#pragma once
+
+enum AssetState{
+    //Queued for import; the asset holds no data yet
+    ASSET_PENDING,
+    //Data is in CPU memory but has not been uploaded to the GPU
+    ASSET_LOADED,
+    //Data has been uploaded to the GPU and can be rendered
+    ASSET_RESIDENT,
+    //Import or upload failed
+    ASSET_FAILED
+};
@@ -3,7 +3,9 @@
 enum ComponentType{
     COMP_TRANSFORM,
     COMP_MATERIAL,
-    COMP_MESH
+    COMP_MESH,
+    //Number of component types. Must remain the last entry
+    COMP_COUNT
 };
 
 class Component{
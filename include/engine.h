@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include "renderer.h"
 #include "scene.h"
 #include "camera.h"
@@ -33,6 +34,28 @@ public:
     /// @return Returns a pointer to the imported data structure if successful. Nullptr if not
     Texture* importImage(const char*, bool = true);
 
+    /// @brief Imports a model on a worker thread. The returned mesh starts in the ASSET_PENDING state and is filled in during a later update
+    /// @param filePath The file path of the model to be imported
+    /// @param pushToGPU If true the mesh data will be pushed to the GPU once decoded, making it ASSET_RESIDENT
+    /// @return Returns a handle to the mesh. Check Mesh::getState for completion or failure
+    Mesh* importMeshAsync(const char*, bool = true);
+
+    /// @brief Imports an image on a worker thread. The returned texture starts in the ASSET_PENDING state and is filled in during a later update
+    /// @param filePath The file path of the image to be imported
+    /// @param pushToGPU If true the image data will be pushed to the GPU once decoded, making it ASSET_RESIDENT
+    /// @return Returns a handle to the texture. Check Texture::getState for completion or failure
+    Texture* importImageAsync(const char*, bool = true);
+
+    /// @brief Releases a reference to a mesh returned by importMesh, importMeshAsync or createPrimitive.
+    ///     The mesh is freed once the last reference is released and the render thread has finished any frame using it
+    /// @param mesh Pointer to the mesh to release. The pointer must not be used after releasing it
+    void releaseMesh(Mesh*);
+
+    /// @brief Releases a reference to an image returned by importImage or importImageAsync.
+    ///     The image is freed once the last reference is released and the render thread has finished any frame using it
+    /// @param image Pointer to the image to release. The pointer must not be used after releasing it
+    void releaseImage(Texture*);
+
     /// @brief Pushes the provided image's data to the GPU through the renderer
     /// @param imageData Pointer to the image whose data is to be uploaded
     /// @return True if successful or data is already uploaded
@@ -74,6 +97,19 @@ public:
     /// @param active When True a camera will render every frame
     void setCameraActive(Camera*, bool);
 
+    /// @brief Sets the projected sizes at which objects switch between the detail levels of their meshes
+    /// @param thresholds Fractions of the view height, largest first. An object whose bounding sphere covers less than thresholds[i] uses level i + 1
+    /// @param hysteresis Fraction a size must pass a threshold by before the level changes, so objects near a threshold don't flicker between levels
+    void setLodThresholds(const std::vector<float>&, float = 0.1f);
+
+    /// @brief Overrides device selection with the first suitable device whose name contains the given text. Must be called before start
+    /// @param name Part of the device name, matched case insensitively. Empty to restore automatic selection
+    void setPreferredDeviceName(std::string);
+
+    /// @brief Overrides device selection with the device at a position in the order the driver lists them. Must be called before start
+    /// @param index Position of the device. Takes precedence over the preferred name
+    void setPreferredDeviceIndex(uint32_t);
+
     void setVertexShaderPath(std::string);
 
     void setFragmentShaderPath(std::string);
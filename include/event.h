@@ -1,53 +1,355 @@
 #pragma once
 
-#include <unordered_map>
-#include <functional>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// @brief Move-only callable wrapper with inline storage. Callables that fit within INLINE_SIZE are stored in place and never allocate
+template<typename... Args>
+class EventDelegate{
+public:
+    //Bytes of inline storage. Enough for a lambda capturing a few pointers
+    static constexpr size_t INLINE_SIZE = 32;
+
+    EventDelegate() : invoker(nullptr), manager(nullptr){}
+
+    template<typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, EventDelegate>::value>>
+    EventDelegate(F&& function){
+        using Callable = std::decay_t<F>;
+
+        if constexpr(fitsInline<Callable>()){
+            new (storage) Callable(std::forward<F>(function));
+            invoker = &invokeInline<Callable>;
+            manager = &manageInline<Callable>;
+        }
+        else{
+            //Too large for the inline buffer; keep a pointer to a heap copy instead
+            Callable* heapCallable = new Callable(std::forward<F>(function));
+            std::memcpy(storage, &heapCallable, sizeof(Callable*));
+            invoker = &invokeHeap<Callable>;
+            manager = &manageHeap<Callable>;
+        }
+    }
+
+    EventDelegate(EventDelegate&& other) noexcept : invoker(other.invoker), manager(other.manager){
+        if(manager != nullptr)
+            manager(Operation::MOVE, other.storage, storage);
+        other.invoker = nullptr;
+        other.manager = nullptr;
+    }
+
+    EventDelegate& operator=(EventDelegate&& other) noexcept{
+        if(this != &other){
+            reset();
+            invoker = other.invoker;
+            manager = other.manager;
+            if(manager != nullptr)
+                manager(Operation::MOVE, other.storage, storage);
+            other.invoker = nullptr;
+            other.manager = nullptr;
+        }
+        return *this;
+    }
+
+    EventDelegate(const EventDelegate&) = delete;
+    EventDelegate& operator=(const EventDelegate&) = delete;
+
+    ~EventDelegate(){
+        reset();
+    }
+
+    /// @brief Invokes the wrapped callable
+    void operator()(Args... args){
+        invoker(storage, args...);
+    }
+
+    /// @brief Returns true if a callable is stored
+    explicit operator bool() const{
+        return invoker != nullptr;
+    }
+
+    /// @brief Destroys the stored callable
+    void reset(){
+        if(manager != nullptr)
+            manager(Operation::DESTROY, storage, nullptr);
+        invoker = nullptr;
+        manager = nullptr;
+    }
+
+private:
+    enum class Operation{
+        MOVE,
+        DESTROY
+    };
+
+    using Invoker = void(*)(void*, Args...);
+    using Manager = void(*)(Operation, void*, void*);
+
+    alignas(std::max_align_t) unsigned char storage[INLINE_SIZE];
+    Invoker invoker;
+    Manager manager;
+
+    template<typename Callable>
+    static constexpr bool fitsInline(){
+        return sizeof(Callable) <= INLINE_SIZE
+            && alignof(Callable) <= alignof(std::max_align_t)
+            && std::is_nothrow_move_constructible<Callable>::value;
+    }
+
+    template<typename Callable>
+    static void invokeInline(void* data, Args... args){
+        (*static_cast<Callable*>(data))(args...);
+    }
+
+    template<typename Callable>
+    static void manageInline(Operation operation, void* source, void* destination){
+        Callable* callable = static_cast<Callable*>(source);
+        if(operation == Operation::MOVE)
+            new (destination) Callable(std::move(*callable));
+        callable->~Callable();
+    }
+
+    template<typename Callable>
+    static void invokeHeap(void* data, Args... args){
+        Callable* callable;
+        std::memcpy(&callable, data, sizeof(Callable*));
+        (*callable)(args...);
+    }
+
+    template<typename Callable>
+    static void manageHeap(Operation operation, void* source, void* destination){
+        if(operation == Operation::MOVE)
+            std::memcpy(destination, source, sizeof(Callable*));
+        else{
+            Callable* callable;
+            std::memcpy(&callable, source, sizeof(Callable*));
+            delete callable;
+        }
+    }
+};
 
 template<typename... Args>
 class Event{
 public:
-    /// @brief Type used for handling registering and unregistering with the event
-    using SubscriptionId = size_t;
-    /// @brief Shorthand for the function type used by the instance of the template
-    using FunctionType = std::function<void(Args...)>;
+    /// @brief Handle used for unregistering from the event. Holds a slot index in the low 32 bits and the slot's generation in the high 32 bits
+    using SubscriptionId = uint64_t;
+    /// @brief Shorthand for the delegate type used by the instance of the template
+    using FunctionType = EventDelegate<Args...>;
+
+    Event() : dispatchDepth(0), hasPendingRemovals(false){}
+
+    Event(const Event&) = delete;
+    Event& operator=(const Event&) = delete;
 
     ~Event(){
         listeners.clear();
     }
 
-    /// @brief Registers a callback to the event
+    /// @brief Registers a callback to the event. Callbacks registered while the event is being invoked are first called on the next invocation
     /// @param listener The callback to register with
     /// @return Returns an id used for unregistering from the event
-    SubscriptionId Register(const FunctionType& listener)
+    template<typename F>
+    SubscriptionId Register(F&& listener)
     {
-        //Fetch the id value and increment the id counter
-        SubscriptionId id = nextId++;
-        //Add the callback to the list
-        listeners[id] = listener;
-        //Return the id
-        return id;
+        //Reuse a free slot if one is available
+        uint32_t slotIndex;
+        if(!freeSlots.empty()){
+            slotIndex = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else{
+            slotIndex = static_cast<uint32_t>(slots.size());
+            slots.push_back({INVALID_INDEX, 0});
+        }
+
+        //Adding to the dense list mid dispatch could move the delegate being invoked, so hold it until the dispatch ends
+        if(dispatchDepth > 0){
+            slots[slotIndex].denseIndex = PENDING_INDEX;
+            pendingListeners.push_back({FunctionType(std::forward<F>(listener)), slotIndex});
+        }
+        else{
+            slots[slotIndex].denseIndex = static_cast<uint32_t>(listeners.size());
+            listeners.push_back({FunctionType(std::forward<F>(listener)), slotIndex});
+        }
+
+        return makeId(slotIndex, slots[slotIndex].generation);
     }
 
-    /// @brief Unregisters a callback from the event
+    /// @brief Unregisters a callback from the event. Safe to call from within a callback
     /// @param id The id of the callback to unregister
     void Unregister(SubscriptionId id)
     {
-        //Remove the entry
-        listeners.erase(id);
+        uint32_t slotIndex = static_cast<uint32_t>(id & 0xFFFFFFFFu);
+        uint32_t generation = static_cast<uint32_t>(id >> 32);
+
+        //Ignore stale or unknown ids
+        if(slotIndex >= slots.size() || slots[slotIndex].generation != generation || slots[slotIndex].denseIndex == INVALID_INDEX)
+            return;
+
+        Slot& slot = slots[slotIndex];
+
+        //Still waiting to be added; flag it so it is dropped from the pending list
+        if(slot.denseIndex == PENDING_INDEX){
+            for(auto& pending : pendingListeners){
+                if(pending.slot == slotIndex)
+                    pending.slot = INVALID_INDEX;
+            }
+            releaseSlot(slotIndex);
+            return;
+        }
+
+        //Removing mid dispatch would shift listeners that haven't been called yet and could destroy the callback that is running
+        //Flag the listener so it is skipped and compact once the dispatch ends
+        if(dispatchDepth > 0){
+            listeners[slot.denseIndex].slot = INVALID_INDEX;
+            hasPendingRemovals = true;
+            releaseSlot(slotIndex);
+            return;
+        }
+
+        removeDense(slot.denseIndex);
+        releaseSlot(slotIndex);
     }
 
     /// @brief Invokes the event
-    /// @param ...args 
+    /// @param ...args
     void Invoke(Args... args)
     {
-        //Go through the map of callbacks and invoke the functions
-        for(const auto& pair : listeners)
-            pair.second(args...);
+        dispatchDepth++;
+        //Walk the dense list by index; listeners added during the dispatch are held in the pending list
+        size_t count = listeners.size();
+        for(size_t idx = 0; idx < count; idx++){
+            if(listeners[idx].slot != INVALID_INDEX)
+                listeners[idx].delegate(args...);
+        }
+        dispatchDepth--;
+
+        if(dispatchDepth == 0)
+            applyDeferredChanges();
+    }
+
+    /// @brief Queues an invocation to be dispatched later by DispatchQueued. Safe to call from any thread
+    /// @param ...args Arguments are copied into the queue
+    void Enqueue(Args... args)
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queuedInvocations.emplace_back(args...);
+    }
+
+    /// @brief Invokes the event once for every queued invocation, in the order they were queued. Call from the thread that owns the listeners
+    void DispatchQueued()
+    {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            if(queuedInvocations.empty())
+                return;
+            //Swap into a local buffer so producers aren't blocked while listeners run
+            dispatchingInvocations.swap(queuedInvocations);
+        }
+
+        for(auto& arguments : dispatchingInvocations)
+            std::apply([this](auto&... values) { Invoke(values...); }, arguments);
+        dispatchingInvocations.clear();
+    }
+
+    /// @brief Returns the number of registered callbacks
+    /// @return
+    size_t Count() const
+    {
+        size_t count = 0;
+        for(const auto& listener : listeners){
+            if(listener.slot != INVALID_INDEX)
+                count++;
+        }
+        for(const auto& pending : pendingListeners){
+            if(pending.slot != INVALID_INDEX)
+                count++;
+        }
+        return count;
     }
 
 private:
-    //Map of IDs to registered callbacks
-    std::unordered_map<SubscriptionId, FunctionType> listeners;
-    //Counter to provide unique IDs for this event on registration of a new callback
-    SubscriptionId nextId = 0;
-};
\ No newline at end of file
+    static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+    static constexpr uint32_t PENDING_INDEX = UINT32_MAX - 1;
+
+    /// @brief Dense entry holding a callback and the slot that refers to it. The slot is INVALID_INDEX once unregistered mid dispatch
+    struct Listener{
+        FunctionType delegate;
+        uint32_t slot;
+    };
+
+    /// @brief Sparse entry mapping a subscription id to its dense listener
+    struct Slot{
+        uint32_t denseIndex;
+        //Incremented every time the slot is released so old ids can't unregister a new listener
+        uint32_t generation;
+    };
+
+    //Registered callbacks, packed so Invoke walks contiguous memory
+    std::vector<Listener> listeners;
+    //Callbacks registered during a dispatch
+    std::vector<Listener> pendingListeners;
+    //Lookup from subscription id to dense index
+    std::vector<Slot> slots;
+    //Slots that can be reused
+    std::vector<uint32_t> freeSlots;
+
+    //Number of Invoke calls currently on the stack
+    int dispatchDepth;
+    //Set when a callback was unregistered during a dispatch
+    bool hasPendingRemovals;
+
+    //Invocations queued by Enqueue
+    std::vector<std::tuple<std::decay_t<Args>...>> queuedInvocations;
+    //Invocations being dispatched by DispatchQueued
+    std::vector<std::tuple<std::decay_t<Args>...>> dispatchingInvocations;
+    std::mutex queueMutex;
+
+    static SubscriptionId makeId(uint32_t slotIndex, uint32_t generation){
+        return (static_cast<SubscriptionId>(generation) << 32) | slotIndex;
+    }
+
+    /// @brief Returns a slot to the free list and invalidates ids referring to it
+    void releaseSlot(uint32_t slotIndex){
+        slots[slotIndex].denseIndex = INVALID_INDEX;
+        slots[slotIndex].generation++;
+        freeSlots.push_back(slotIndex);
+    }
+
+    /// @brief Removes a dense listener by moving the last listener into its place
+    void removeDense(uint32_t denseIndex){
+        uint32_t last = static_cast<uint32_t>(listeners.size() - 1);
+        if(denseIndex != last){
+            listeners[denseIndex] = std::move(listeners[last]);
+            slots[listeners[denseIndex].slot].denseIndex = denseIndex;
+        }
+        listeners.pop_back();
+    }
+
+    /// @brief Applies registrations and removals made during a dispatch
+    void applyDeferredChanges(){
+        //Compact out listeners unregistered during the dispatch. Walking backwards means the listener moved into a removed entry is always live
+        if(hasPendingRemovals){
+            for(size_t idx = listeners.size(); idx-- > 0;){
+                if(listeners[idx].slot == INVALID_INDEX)
+                    removeDense(static_cast<uint32_t>(idx));
+            }
+            hasPendingRemovals = false;
+        }
+
+        //Move listeners registered during the dispatch into the dense list
+        for(auto& pending : pendingListeners){
+            if(pending.slot == INVALID_INDEX)
+                continue;
+            slots[pending.slot].denseIndex = static_cast<uint32_t>(listeners.size());
+            listeners.push_back(std::move(pending));
+        }
+        pendingListeners.clear();
+    }
+};
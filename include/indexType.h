@@ -0,0 +1,8 @@
+#pragma once
+
+enum IndexType{
+    //16 bit indices; used while every index fits
+    INDEX_TYPE_UINT16,
+    //32 bit indices; used once a mesh references more than 65536 vertices
+    INDEX_TYPE_UINT32
+};
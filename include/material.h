@@ -5,6 +5,9 @@
 
 class Material : public Component{
 public:
+    //Compile time component type id
+    static constexpr ComponentType staticType = ComponentType::COMP_MATERIAL;
+
     Texture* albedo;
 
     Material();
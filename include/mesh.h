@@ -1,19 +1,156 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <vector>
 #include "vertex.h"
 #include "component.h"
+#include "assetState.h"
+#include "indexType.h"
+#include "meshlet.h"
+#include "meshLod.h"
 
 class RendererData;
+
+/// @brief Vertex and index data read in place from a memory mapped cooked mesh file. Vertices are already in the packed GPU layout
+struct MeshSourceView{
+    //Keeps the mapping alive while the view is in use. Empty if the mesh isn't backed by a mapped file
+    std::shared_ptr<const void> owner;
+    const void* vertexData;
+    size_t vertexCount;
+    size_t vertexDataSize;
+    const void* indexData;
+    size_t indexCount;
+    size_t indexDataSize;
+    IndexType indexType;
+    const Meshlet* meshletData;
+    size_t meshletCount;
+    const MeshLod* lodData;
+    size_t lodCount;
+};
+
 class Mesh : public Component{
 public:
+    //Compile time component type id
+    static constexpr ComponentType staticType = ComponentType::COMP_MESH;
+
     std::unique_ptr<RendererData> pRendererData;
 
     std::vector<Vertex> vertices;
-    std::vector<uint16_t> indices;
+
+    //Clusters of the index buffer used for culling. Built on import; empty meshes are drawn whole
+    std::vector<Meshlet> meshlets;
+
+    //Detail levels from full resolution down, each a range of the index buffer and of the meshlets. Meshes without levels are drawn at full resolution
+    std::vector<MeshLod> lods;
+
+    //Mapped geometry used in place of vertices and indices when the mesh was loaded from a cooked file
+    MeshSourceView mappedData;
+
+    //Object space bounds of the vertex positions. Packed positions are quantized against them
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
     
     Mesh();
     Mesh(const Mesh&);
     Mesh(std::vector<Vertex>, std::vector<uint16_t>, unsigned char*);
+
+    /// @brief Writes the vertices in the packed layout uploaded to the GPU. Mapped data is copied as is, otherwise the vertices vector is packed against the bounds
+    /// @param destination Memory of at least getVertexDataSize bytes
+    void writeVertexData(void*) const;
+
+    /// @brief Returns the size in bytes of the packed vertex data
+    /// @return
+    size_t getVertexDataSize() const;
+
+    /// @brief Returns the size in bytes of a single packed vertex
+    /// @return
+    uint32_t getVertexStride() const;
+
+    /// @brief Returns the matrix that expands packed positions from the unit cube back to the mesh bounds. Applied before the model matrix
+    /// @return
+    glm::mat4 getDequantizationMatrix() const;
+
+    /// @brief Returns the number of vertices
+    /// @return
+    size_t getVertexCount() const;
+
+    /// @brief Returns a vertex at full precision; mapped vertices are unpacked against the bounds
+    /// @param index Index of the vertex
+    /// @return
+    Vertex getVertex(size_t) const;
+
+    /// @brief Replaces the indices of the mesh, storing them in the narrowest type that can address every vertex
+    /// @param indices The new indices
+    void setIndices(const std::vector<uint32_t>&);
+
+    /// @brief Replaces the indices of the mesh, storing them in the narrowest type that can address every vertex
+    /// @param indices Pointer to the new indices
+    /// @param count Number of indices
+    void setIndices(const uint32_t*, size_t);
+
+    /// @brief Returns a copy of the indices widened to 32 bits
+    /// @return
+    std::vector<uint32_t> getIndices() const;
+
+    /// @brief Returns the index at a position
+    /// @param position Position in the index list
+    /// @return
+    uint32_t getIndex(size_t) const;
+
+    /// @brief Returns the type the indices are stored as
+    /// @return
+    IndexType getIndexType() const;
+
+    /// @brief Returns a pointer to the index data; the mapped data if present, otherwise the stored indices
+    /// @return
+    const void* getIndexData() const;
+
+    /// @brief Returns the size in bytes of the index data
+    /// @return
+    size_t getIndexDataSize() const;
+
+    /// @brief Returns the number of indices
+    /// @return
+    uint32_t getIndexCount() const;
+
+    /// @brief Returns the meshlets of the mesh; the mapped meshlets if present, otherwise the meshlets vector
+    /// @return
+    const Meshlet* getMeshlets() const;
+
+    /// @brief Returns the number of meshlets
+    /// @return
+    size_t getMeshletCount() const;
+
+    /// @brief Returns the detail levels of the mesh; the mapped levels if present, otherwise the lods vector
+    /// @return
+    const MeshLod* getLods() const;
+
+    /// @brief Returns the number of detail levels. 0 if the mesh was never simplified
+    /// @return
+    size_t getLodCount() const;
+
+    /// @brief Recalculates boundsMin and boundsMax from the vertices vector. Mapped meshes keep the bounds they were cooked with
+    void computeBounds();
+
+    /// @brief Moves the vertices, indices, meshlets, detail levels, mapped data and bounds out of another mesh
+    /// @param source The mesh to take the geometry from. Left empty
+    void takeGeometry(Mesh&);
+
+    /// @brief Returns the load state of the mesh. Only resident meshes are rendered
+    /// @return
+    AssetState getState() const;
+
+    /// @brief Sets the load state of the mesh. Managed by the engine
+    /// @param state The new state
+    void setState(AssetState);
+
+private:
+    //Type of the stored indices; only the matching vector is populated
+    IndexType indexType;
+    std::vector<uint16_t> shortIndices;
+    std::vector<uint32_t> longIndices;
+
+    //Load state; written by the engine and read by the render snapshot
+    std::atomic<AssetState> state;
 };
\ No newline at end of file
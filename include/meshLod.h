@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+/// @brief One level of detail of a mesh. Every level shares the mesh's vertices; its triangles are a range of the mesh's index buffer
+struct MeshLod{
+    //Range of the level's indices within the mesh's index buffer
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    //Range of the level's meshlets within the mesh's meshlets
+    uint32_t firstMeshlet;
+    uint32_t meshletCount;
+    //Simplification error as a fraction of the mesh's bounding diagonal. 0 for the full resolution level
+    float error;
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+/// @brief Cluster of neighbouring triangles that is culled as a unit. A meshlet is a contiguous range of the mesh's index buffer
+struct Meshlet{
+    //First index of the meshlet's triangles in the mesh's index buffer
+    uint32_t firstIndex;
+    //Number of indices; three per triangle
+    uint32_t indexCount;
+    //Number of unique vertices referenced by the meshlet
+    uint32_t vertexCount;
+
+    //Object space bounding sphere
+    glm::vec3 center;
+    float radius;
+
+    //Normal cone containing every triangle normal. Cosine and sine of the widest angle between the axis and a triangle normal
+    //A cone with coneCos <= 0 spans a hemisphere or more and can't be used for backface culling
+    glm::vec3 coneAxis;
+    float coneCos;
+    float coneSin;
+};
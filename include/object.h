@@ -13,6 +13,35 @@ public:
     ~Object();
     bool addComponent(Component*);
     Component* getComponent(const ComponentType);
+
+    /// @brief Returns the object's component of type T using its compile time type id
+    /// @return Nullptr if the object does not have the component
+    template<typename T>
+    T* getComponent(){
+        return static_cast<T*>(getComponent(T::staticType));
+    }
+
+    /// @brief Flags the object as never moving. Static objects are merged into batches by material when their scene is made active;
+    ///     changes to the flag, transform or mesh of a static object take effect the next time the scene is activated
+    /// @param isStatic True if the object never moves
+    void setStatic(bool);
+
+    /// @brief Returns true if the object is flagged as static
+    /// @return
+    bool getIsStatic() const;
+
+    /// @brief Returns the object's entity in the engine's component registry
+    /// @return
+    uint32_t getEntity() const;
+
+    /// @brief Returns the detail level last selected for the object's mesh
+    /// @return
+    uint32_t getLodLevel() const;
+
+    /// @brief Sets the detail level selected for the object's mesh. Managed by the engine, which uses it to apply hysteresis between levels
+    /// @param level The new level
+    void setLodLevel(uint32_t);
+
     virtual void cleanup();
     virtual void update(float);
 
@@ -7,6 +7,7 @@
 #include "object.h"
 
 class GLFWwindow;
+struct FrameSnapshot;
 
 class Renderer {
 public:
@@ -19,16 +20,21 @@ public:
     /// @brief Path to the fragment shader file
     std::string fragmentShaderPath;
 
+    /// @brief Part of the name of the device to render with, matched case insensitively. Empty to pick the highest scoring device
+    std::string preferredDeviceName;
+
+    /// @brief Position of the device to render with in the order the driver lists them. Takes precedence over preferredDeviceName
+    std::optional<uint32_t> preferredDeviceIndex;
+
     /// @brief Pure virtual method used to initialize a renderer
     /// @param a_window The GLFW window instance to be used
     /// @param a_width The width of the window
     /// @param a_height The height of the window
     virtual void initialize(GLFWwindow*, int, int, std::reference_wrapper<Event<int,int>>) = 0;
 
-    /// @brief Pure virtual method used to run the renderer
-    /// @param camera The camera that is being rendered
-    /// @param objects The objects to be rendered
-    virtual bool render(Camera*, std::vector<Object*>) = 0;
+    /// @brief Pure virtual method used to render a frame. Called from the render thread
+    /// @param snapshot The views and draws captured by the main thread for the frame
+    virtual bool render(const FrameSnapshot&) = 0;
 
     /// @brief Pure virtual method used to clean up the renderer
     virtual void cleanup() = 0;
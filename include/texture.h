@@ -1,6 +1,8 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
+#include "assetState.h"
 
 class RendererData;
 class Texture{
@@ -13,4 +15,16 @@ public:
 
     Texture();
     Texture(int, int, int);
+
+    /// @brief Returns the load state of the texture. Draws using a texture that isn't resident are skipped
+    /// @return
+    AssetState getState() const;
+
+    /// @brief Sets the load state of the texture. Managed by the engine
+    /// @param state The new state
+    void setState(AssetState);
+
+private:
+    //Load state; written by the engine and read by the render snapshot
+    std::atomic<AssetState> state;
 };
\ No newline at end of file
@@ -1,22 +1,80 @@
 #pragma once
 
+#include <cstdint>
+#include <vector>
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include "component.h"
 
+class TransformStore;
+
+/// @brief Handle to an entry in the engine's transform store. Position, rotation, scale and the cached matrices are stored contiguously by the store
+///     Dirty state is tracked by the store rather than Component::isDirty; use getIsDirty()
 class Transform : public Component{
 public:
-    glm::vec3 position;
-    glm::vec3 rotation;
-    glm::vec3 scale;
-
-    glm::quat quatRot;
+    //Compile time component type id
+    static constexpr ComponentType staticType = ComponentType::COMP_TRANSFORM;
 
     Transform();
+    ~Transform();
+
+    //Handles own their store entry and cannot be copied
+    Transform(const Transform&) = delete;
+    Transform& operator=(const Transform&) = delete;
 
     void setPosition(glm::vec3);
+    glm::vec3 getPosition() const;
+
+    /// @brief Sets the rotation from euler angles
+    /// @param rotation Euler angles in degrees
     void setRotation(glm::vec3);
+
+    /// @brief Returns the rotation as euler angles in degrees
+    /// @return
+    glm::vec3 getRotation() const;
+
+    /// @brief Sets the rotation from a quaternion
+    /// @param rotation
+    void setQuaternion(glm::quat);
+    glm::quat getQuaternion() const;
+
     void setScale(glm::vec3);
+    glm::vec3 getScale() const;
+
     glm::mat4 getRotationMatrix() const;
+
+    /// @brief Returns the cached local space matrix. Updated by the engine once per frame
+    /// @return
+    glm::mat4 getLocalMatrix() const;
+
+    /// @brief Returns the cached world space matrix. Updated by the engine once per frame
+    /// @return
     glm::mat4 getTransformMatrix() const;
-};
\ No newline at end of file
+
+    /// @brief Sets the parent of the transform. Local values are kept so the transform will move with its new parent
+    /// @param parent The new parent transform. Nullptr detaches the transform into a root
+    /// @return False if the parent would create a cycle in the hierarchy
+    bool setParent(Transform*);
+
+    /// @brief Returns the parent transform or nullptr if this is a root transform
+    /// @return
+    Transform* getParent() const;
+
+    /// @brief Returns the list of child transforms
+    /// @return
+    std::vector<Transform*> getChildren() const;
+
+    /// @brief Returns true if the transform has changed since the last store update
+    /// @return
+    bool getIsDirty() const;
+
+    /// @brief Returns the id of the transform's entry in the store
+    /// @return
+    uint32_t getId() const;
+
+private:
+    //Store that holds the transform data
+    TransformStore* store;
+    //Id of the entry within the store
+    uint32_t id;
+};
@@ -8,7 +8,7 @@ layout(location = 0) in vec3 fragColor;
 //Input variable for vertex texture coordinates
 layout(location = 1) in vec2 fragTexCoord;
 
-layout(binding = 0) uniform sampler2D texSampler;
+layout(set = 1, binding = 0) uniform sampler2D texSampler;
 
 void main(){
     outColor = texture(texSampler, fragTexCoord);
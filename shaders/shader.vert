@@ -1,14 +1,34 @@
 #version 450
 
-layout(push_constant) uniform PushConstants{
-    //Model, View, Projection matrix
-    mat4 mvp;
-} pushConstants;
+//Matrices of the view being drawn. Bound once per view through a dynamic offset; matches ViewGpuData on the CPU
+layout(std140, set = 0, binding = 1) uniform ViewData{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    //Normalized frustum planes pointing inwards
+    vec4 frustumPlanes[6];
+    //World space camera position
+    vec4 position;
+} viewData;
 
-//Input variable for 3D vertex position
-layout(location = 0) in vec3 inPosition;
+//Per-object data; matches ObjectGpuData on the CPU
+struct ObjectData{
+    //Model matrix with the mesh bounds folded in
+    mat4 model;
+    //World space bounding sphere
+    vec4 boundsSphere;
+    uint materialIndex;
+};
+
+//Every object's data, indexed by the draw's first instance
+layout(std430, set = 0, binding = 0) readonly buffer ObjectBuffer{
+    ObjectData objects[];
+} objectBuffer;
+
+//Input variable for 3D vertex position. Normalized against the mesh bounds; the bounds are folded into the model matrix
+layout(location = 0) in vec4 inPosition;
 //Input variable for vertex color
-layout(location = 1) in vec3 inColor;
+layout(location = 1) in vec4 inColor;
 //Input variable for vertex UV
 layout(location = 2) in vec2 inTexCoord;
 
@@ -21,11 +41,11 @@ void main(){
     //"gl_Position" is a built in variable that acts as the output
     //"gl_VertexIndex" is the index of the current vertex
     //Translate the model in 3D space
-    gl_Position = pushConstants.mvp * vec4(inPosition, 1.0);
+    gl_Position = viewData.viewProjection * objectBuffer.objects[gl_InstanceIndex].model * vec4(inPosition.xyz, 1.0);
     //gl_Position = vec4(inPosition, 1.0);
 
     //Assign the color to the input color
-    fragColor = inColor;
+    fragColor = inColor.rgb;
     //Assign the texture coordinates
     fragTexCoord = inTexCoord;
 }
\ No newline at end of file
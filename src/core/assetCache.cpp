@@ -0,0 +1,45 @@
+#include <filesystem>
+#include <fstream>
+#include "assetCache.h"
+
+namespace{
+    constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+    constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+    uint64_t fnv1a(uint64_t hash, const unsigned char* data, size_t size){
+        for(size_t idx = 0; idx < size; idx++){
+            hash ^= data[idx];
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
+}
+
+std::string AssetKey::normalizePath(const char* filePath){
+    std::error_code error;
+    std::filesystem::path path = std::filesystem::absolute(filePath, error);
+    //Fall back to the path as given if it can't be made absolute
+    if(error)
+        path = filePath;
+    return path.lexically_normal().generic_string();
+}
+
+uint64_t AssetKey::hashContent(const void* data, size_t size){
+    uint64_t hash = fnv1a(FNV_OFFSET_BASIS, static_cast<const unsigned char*>(data), size);
+    return hash != 0 ? hash : 1;
+}
+
+uint64_t AssetKey::hashFile(const std::string& filePath){
+    std::ifstream file(filePath, std::ios::binary);
+    if(!file.is_open())
+        return 0;
+
+    //Hash in fixed size blocks so large files aren't read into memory at once
+    char buffer[64 * 1024];
+    uint64_t hash = FNV_OFFSET_BASIS;
+    while(file){
+        file.read(buffer, sizeof(buffer));
+        hash = fnv1a(hash, reinterpret_cast<const unsigned char*>(buffer), static_cast<size_t>(file.gcount()));
+    }
+    return hash != 0 ? hash : 1;
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+class Mesh;
+class Texture;
+
+/// @brief Reference counted lookup of a single asset type by normalized path and by content hash
+template<typename T>
+class AssetTable{
+public:
+    /// @brief Returns the asset imported from a path and adds a reference to it
+    /// @param path The normalized path of the asset
+    /// @return Nullptr if no asset has been imported from the path
+    T* acquireByPath(const std::string& path){
+        auto iterator = byPath.find(path);
+        if(iterator == byPath.end())
+            return nullptr;
+        entries[iterator->second].refCount++;
+        return iterator->second;
+    }
+
+    /// @brief Returns an asset with identical content and adds a reference to it. The path is recorded as an alias of the asset
+    /// @param path The normalized path being requested
+    /// @param contentHash Hash of the file's contents
+    /// @return Nullptr if no asset with the same content is cached
+    T* acquireByContent(const std::string& path, uint64_t contentHash){
+        auto iterator = byHash.find(contentHash);
+        if(iterator == byHash.end())
+            return nullptr;
+        entries[iterator->second].refCount++;
+        byPath[path] = iterator->second;
+        entries[iterator->second].aliases++;
+        return iterator->second;
+    }
+
+    /// @brief Adds a newly created asset with a single reference
+    /// @param asset The asset to add
+    /// @param path The normalized path the asset was imported from
+    /// @param contentHash Hash of the file's contents. 0 if not known yet
+    void insert(T* asset, const std::string& path, uint64_t contentHash = 0){
+        Entry& entry = entries[asset];
+        entry.path = path;
+        entry.contentHash = 0;
+        entry.refCount = 1;
+        entry.aliases = 1;
+        byPath[path] = asset;
+        setContentHash(asset, contentHash);
+    }
+
+    /// @brief Records the content hash of an asset once it is known. The first asset with a given hash is the one shared
+    /// @param asset The asset to update
+    /// @param contentHash Hash of the file's contents
+    void setContentHash(T* asset, uint64_t contentHash){
+        auto iterator = entries.find(asset);
+        if(iterator == entries.end() || contentHash == 0)
+            return;
+        iterator->second.contentHash = contentHash;
+        byHash.emplace(contentHash, asset);
+    }
+
+    /// @brief Adds a reference to a cached asset
+    /// @param asset The asset to reference
+    /// @return False if the asset is not tracked by the table
+    bool addReference(T* asset){
+        auto iterator = entries.find(asset);
+        if(iterator == entries.end())
+            return false;
+        iterator->second.refCount++;
+        return true;
+    }
+
+    /// @brief Removes a reference from an asset. The asset is dropped from the table when the last reference goes
+    /// @param asset The asset to release
+    /// @return True if that was the last reference and the caller should destroy the asset
+    bool release(T* asset){
+        auto iterator = entries.find(asset);
+        if(iterator == entries.end())
+            return false;
+
+        Entry& entry = iterator->second;
+        if(--entry.refCount > 0)
+            return false;
+
+        removeLookups(asset, entry);
+        entries.erase(iterator);
+        return true;
+    }
+
+    /// @brief Stops an asset being returned by path or content lookups, so the next import of its paths loads them again.
+    ///     References already held stay tracked and are released as usual
+    /// @param asset The asset to evict
+    void evict(T* asset){
+        auto iterator = entries.find(asset);
+        if(iterator != entries.end())
+            removeLookups(asset, iterator->second);
+    }
+
+    /// @brief Returns the number of references held on an asset
+    /// @param asset The asset to check
+    /// @return 0 if the asset is not tracked by the table
+    uint32_t getReferenceCount(const T* asset) const{
+        auto iterator = entries.find(const_cast<T*>(asset));
+        return iterator != entries.end() ? iterator->second.refCount : 0;
+    }
+
+    /// @brief Returns the number of unique assets in the table
+    /// @return
+    size_t size() const{
+        return entries.size();
+    }
+
+private:
+    struct Entry{
+        //Path the asset was first imported from
+        std::string path;
+        //Hash of the source file. 0 when not known
+        uint64_t contentHash;
+        //Number of outstanding handles
+        uint32_t refCount;
+        //Number of paths mapped to the asset
+        uint32_t aliases;
+    };
+
+    /// @brief Removes every path and the content hash pointing at an asset
+    /// @param asset The asset to remove
+    /// @param entry The asset's entry
+    void removeLookups(T* asset, Entry& entry){
+        for(auto pathIterator = byPath.begin(); entry.aliases > 0 && pathIterator != byPath.end();){
+            if(pathIterator->second == asset){
+                pathIterator = byPath.erase(pathIterator);
+                entry.aliases--;
+            }
+            else
+                ++pathIterator;
+        }
+        auto hashIterator = byHash.find(entry.contentHash);
+        if(hashIterator != byHash.end() && hashIterator->second == asset)
+            byHash.erase(hashIterator);
+        entry.contentHash = 0;
+    }
+
+    std::unordered_map<std::string, T*> byPath;
+    std::unordered_map<uint64_t, T*> byHash;
+    std::unordered_map<T*, Entry> entries;
+};
+
+/// @brief Helpers used to key cached assets
+namespace AssetKey{
+    /// @brief Converts a path into the form used as a cache key; absolute, lexically normalized and with forward slashes
+    /// @param filePath The path to normalize
+    /// @return
+    std::string normalizePath(const char*);
+
+    /// @brief Hashes a block of memory with 64 bit FNV-1a. Never returns 0, which is reserved for unknown hashes
+    /// @param data Pointer to the data
+    /// @param size Number of bytes to hash
+    /// @return
+    uint64_t hashContent(const void*, size_t);
+
+    /// @brief Hashes the contents of a file
+    /// @param filePath The file to hash
+    /// @return Returns 0 if the file can't be read
+    uint64_t hashFile(const std::string&);
+}
+
+/// @brief Engine owned cache of imported assets. Repeat requests for the same path or the same file contents share one handle
+struct AssetCache{
+    AssetTable<Mesh> meshes;
+    AssetTable<Texture> textures;
+};
@@ -119,9 +119,13 @@ glm::mat4 Camera::getViewMatrix(){
 }
 glm::mat4 Camera::CameraImpl::getViewMatrix(const Transform* transform){
     glm::mat4 output = glm::mat4(1.0f);
-    output = glm::translate(output, transform->position + offset);
+    output = glm::translate(output, transform->getPosition() + offset);
     output *= transform->getRotationMatrix();
 
+    //Place the camera relative to its parent if it is part of a hierarchy
+    if(transform->getParent() != nullptr)
+        output = transform->getParent()->getTransformMatrix() * output;
+
     output = glm::inverse(output);
     return output;
 }
@@ -0,0 +1,80 @@
+#include "componentRegistry.h"
+
+ComponentRegistry* ComponentRegistry::activeRegistry = nullptr;
+
+ComponentRegistry::ComponentRegistry(){
+}
+
+ComponentRegistry::~ComponentRegistry(){
+    if(activeRegistry == this)
+        activeRegistry = nullptr;
+}
+
+ComponentRegistry* ComponentRegistry::getActive(){
+    return activeRegistry;
+}
+
+void ComponentRegistry::setActive(ComponentRegistry* registry){
+    activeRegistry = registry;
+}
+
+ComponentRegistry::Entity ComponentRegistry::createEntity(Object* owner){
+    //Reuse a released entity if one is available
+    if(!freeEntities.empty()){
+        Entity entity = freeEntities.back();
+        freeEntities.pop_back();
+        entityOwners[entity] = owner;
+        return entity;
+    }
+
+    entityOwners.push_back(owner);
+    return static_cast<Entity>(entityOwners.size() - 1);
+}
+
+void ComponentRegistry::destroyEntity(Entity entity){
+    for(int type = 0; type < ComponentType::COMP_COUNT; type++)
+        removeComponent(entity, static_cast<ComponentType>(type));
+
+    entityOwners[entity] = nullptr;
+    freeEntities.push_back(entity);
+}
+
+bool ComponentRegistry::addComponent(Entity entity, Component* component){
+    ComponentPool& pool = pools[component->type];
+
+    //Grow the sparse lookup to cover the entity
+    if(entity >= pool.sparse.size())
+        pool.sparse.resize(entity + 1, INVALID_INDEX);
+
+    //Only one component of each type per entity
+    if(pool.sparse[entity] != INVALID_INDEX)
+        return false;
+
+    pool.sparse[entity] = static_cast<uint32_t>(pool.components.size());
+    pool.entities.push_back(entity);
+    pool.owners.push_back(entityOwners[entity]);
+    pool.components.push_back(component);
+    return true;
+}
+
+bool ComponentRegistry::removeComponent(Entity entity, ComponentType componentType){
+    ComponentPool& pool = pools[componentType];
+    if(entity >= pool.sparse.size() || pool.sparse[entity] == INVALID_INDEX)
+        return false;
+
+    //Move the last entry into the removed slot to keep the arrays packed
+    uint32_t index = pool.sparse[entity];
+    uint32_t last = static_cast<uint32_t>(pool.components.size() - 1);
+    if(index != last){
+        pool.entities[index] = pool.entities[last];
+        pool.owners[index] = pool.owners[last];
+        pool.components[index] = pool.components[last];
+        pool.sparse[pool.entities[index]] = index;
+    }
+
+    pool.entities.pop_back();
+    pool.owners.pop_back();
+    pool.components.pop_back();
+    pool.sparse[entity] = INVALID_INDEX;
+    return true;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "component.h"
+
+class Object;
+
+/// @brief Engine owned sparse-set storage of object components.
+///     Each component type has its own pool with a sparse entity lookup and densely packed component and owner arrays
+///     Mesh and Material instances are shared between objects, so the pools hold component pointers rather than values
+class ComponentRegistry{
+public:
+    using Entity = uint32_t;
+    static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+    /// @brief Densely packed storage for a single component type
+    struct ComponentPool{
+        //Maps an entity to its index in the dense arrays
+        std::vector<uint32_t> sparse;
+        //Entity of each dense entry
+        std::vector<Entity> entities;
+        //Owning object of each dense entry
+        std::vector<Object*> owners;
+        //Component of each dense entry
+        std::vector<Component*> components;
+    };
+
+    ComponentRegistry();
+    ~ComponentRegistry();
+
+    /// @brief Returns the registry that new objects register with
+    /// @return
+    static ComponentRegistry* getActive();
+
+    /// @brief Sets the registry that new objects register with
+    /// @param registry The registry to make active
+    static void setActive(ComponentRegistry*);
+
+    /// @brief Creates an entity with no components
+    /// @param owner The object the entity represents
+    /// @return Returns the new entity
+    Entity createEntity(Object*);
+
+    /// @brief Removes all components from an entity and releases it
+    /// @param entity The entity to destroy
+    void destroyEntity(Entity);
+
+    /// @brief Adds a component to an entity
+    /// @param entity The entity to add the component to
+    /// @param component The component to add
+    /// @return False if the entity already has a component of the same type
+    bool addComponent(Entity, Component*);
+
+    /// @brief Removes a component type from an entity
+    /// @param entity The entity to remove the component from
+    /// @param componentType The type of component to remove
+    /// @return False if the entity did not have the component
+    bool removeComponent(Entity, ComponentType);
+
+    /// @brief Returns an entity's component of the given type
+    /// @param entity The entity to search
+    /// @param componentType The type of component to fetch
+    /// @return Nullptr if the entity does not have the component
+    Component* getComponent(Entity entity, ComponentType componentType) const{
+        const ComponentPool& pool = pools[componentType];
+        if(entity >= pool.sparse.size() || pool.sparse[entity] == INVALID_INDEX)
+            return nullptr;
+        return pool.components[pool.sparse[entity]];
+    }
+
+    /// @brief Returns an entity's component of type T
+    /// @param entity The entity to search
+    /// @return Nullptr if the entity does not have the component
+    template<typename T>
+    T* getComponent(Entity entity) const{
+        return static_cast<T*>(getComponent(entity, T::staticType));
+    }
+
+    /// @brief Returns the pool for a component type so systems can iterate it directly
+    /// @param componentType The type of the pool
+    /// @return
+    const ComponentPool& getPool(ComponentType componentType) const{
+        return pools[componentType];
+    }
+
+    /// @brief Invokes a function for every object that has a component of type T, walking the pool's dense arrays
+    /// @param function Callable taking (Object*, T*)
+    template<typename T, typename Func>
+    void forEach(Func function) const{
+        const ComponentPool& pool = pools[T::staticType];
+        for(size_t idx = 0; idx < pool.components.size(); idx++)
+            function(pool.owners[idx], static_cast<T*>(pool.components[idx]));
+    }
+
+private:
+    //One pool per component type indexed by the compile time type id
+    std::array<ComponentPool, ComponentType::COMP_COUNT> pools;
+    //Owning object of each entity
+    std::vector<Object*> entityOwners;
+    //Entities that have been released and can be reused
+    std::vector<Entity> freeEntities;
+
+    //Registry new objects register with
+    static ComponentRegistry* activeRegistry;
+};
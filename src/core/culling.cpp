@@ -0,0 +1,130 @@
+#include "culling.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "frameSnapshot.h"
+
+Frustum Frustum::fromMatrix(const glm::mat4& matrix){
+    //Rows of the matrix; glm matrices are column major
+    glm::vec4 rows[4];
+    for(int row = 0; row < 4; row++)
+        rows[row] = glm::vec4(matrix[0][row], matrix[1][row], matrix[2][row], matrix[3][row]);
+
+    Frustum frustum;
+    frustum.planes[0] = rows[3] + rows[0];
+    frustum.planes[1] = rows[3] - rows[0];
+    frustum.planes[2] = rows[3] + rows[1];
+    frustum.planes[3] = rows[3] - rows[1];
+    frustum.planes[4] = rows[3] + rows[2];
+    frustum.planes[5] = rows[3] - rows[2];
+
+    //Normalize so plane distances are in world units and can be compared against radii
+    for(auto& plane : frustum.planes){
+        float length = glm::length(glm::vec3(plane.x, plane.y, plane.z));
+        if(length > 0.0f)
+            plane = plane / length;
+    }
+    return frustum;
+}
+
+bool Frustum::intersectsSphere(glm::vec3 center, float radius) const{
+    for(const auto& plane : planes){
+        if(glm::dot(glm::vec3(plane.x, plane.y, plane.z), center) + plane.w < -radius)
+            return false;
+    }
+    return true;
+}
+
+CullingView Culling::makeView(const SnapshotView& snapshotView){
+    CullingView view;
+    view.frustum = Frustum::fromMatrix(snapshotView.viewProjectionMatrix);
+
+    //Camera view matrices are rigid, so the camera position is the translation rotated back by the transposed rotation
+    const glm::mat4& viewMatrix = snapshotView.viewMatrix;
+    glm::vec3 translation(viewMatrix[3].x, viewMatrix[3].y, viewMatrix[3].z);
+    for(int axis = 0; axis < 3; axis++)
+        view.position[axis] = -glm::dot(glm::vec3(viewMatrix[axis].x, viewMatrix[axis].y, viewMatrix[axis].z), translation);
+
+    //The engine's default projection flips Y, under which counter-clockwise triangles with outward normals face the camera
+    view.facing = snapshotView.projectionMatrix[1][1] < 0.0f ? 1.0f : -1.0f;
+    view.projectionScale = std::fabs(snapshotView.projectionMatrix[1][1]);
+    return view;
+}
+
+CullingInstance Culling::makeInstance(const glm::mat4& modelMatrix){
+    CullingInstance instance;
+    instance.modelMatrix = modelMatrix;
+
+    glm::vec3 axes[3];
+    float minScale = 0.0f;
+    float maxScale = 0.0f;
+    for(int axis = 0; axis < 3; axis++){
+        axes[axis] = glm::vec3(modelMatrix[axis].x, modelMatrix[axis].y, modelMatrix[axis].z);
+        float scale = glm::length(axes[axis]);
+        minScale = axis == 0 ? scale : std::min(minScale, scale);
+        maxScale = axis == 0 ? scale : std::max(maxScale, scale);
+    }
+    instance.maxScale = maxScale;
+    instance.coneUsable = minScale > 0.0f && maxScale - minScale <= maxScale * 1e-3f;
+    instance.facing = glm::dot(glm::cross(axes[0], axes[1]), axes[2]) < 0.0f ? -1.0f : 1.0f;
+    return instance;
+}
+
+bool Culling::isMeshletVisible(const Meshlet& meshlet, const CullingInstance& instance, const CullingView& view){
+    const glm::mat4& model = instance.modelMatrix;
+    glm::vec4 worldCenter = model * glm::vec4(meshlet.center, 1.0f);
+    glm::vec3 center(worldCenter.x, worldCenter.y, worldCenter.z);
+    float radius = meshlet.radius * instance.maxScale;
+
+    if(!view.frustum.intersectsSphere(center, radius))
+        return false;
+
+    if(!instance.coneUsable || meshlet.coneCos <= 0.0f)
+        return true;
+
+    //Every point of the meshlet is within angle beta of the direction to its center. The camera inside the sphere sees it from all sides
+    glm::vec3 toCenter = center - view.position;
+    float distance = glm::length(toCenter);
+    if(distance <= radius)
+        return true;
+    float sinBeta = radius / distance;
+    float cosBeta = std::sqrt(1.0f - sinBeta * sinBeta);
+
+    //Widening the cone by beta past a right angle leaves some normal that could face the camera
+    if(meshlet.coneCos * cosBeta - meshlet.coneSin * sinBeta <= 0.0f)
+        return true;
+
+    glm::vec4 worldAxis = model * glm::vec4(meshlet.coneAxis, 0.0f);
+    glm::vec3 axis = glm::normalize(glm::vec3(worldAxis.x, worldAxis.y, worldAxis.z)) * (instance.facing * view.facing);
+
+    //Backfacing for every normal and every point when the axis points away from the camera by more than the widened cone
+    float sinWidened = meshlet.coneSin * cosBeta + meshlet.coneCos * sinBeta;
+    return glm::dot(axis, toCenter / distance) <= sinWidened;
+}
+
+bool Culling::isMeshletVisible(const Meshlet& meshlet, const CullingInstance& instance, const CullingView* views, size_t viewCount){
+    for(size_t idx = 0; idx < viewCount; idx++){
+        if(isMeshletVisible(meshlet, instance, views[idx]))
+            return true;
+    }
+    return false;
+}
+
+bool Culling::isSphereVisible(glm::vec3 center, float radius, const CullingView* views, size_t viewCount){
+    for(size_t idx = 0; idx < viewCount; idx++){
+        if(views[idx].frustum.intersectsSphere(center, radius))
+            return true;
+    }
+    return false;
+}
+
+float Culling::getProjectedSize(glm::vec3 center, float radius, const CullingView* views, size_t viewCount){
+    float size = 0.0f;
+    for(size_t idx = 0; idx < viewCount; idx++){
+        float distance = glm::length(center - views[idx].position);
+        if(distance <= radius)
+            return std::numeric_limits<float>::infinity();
+        size = std::max(size, radius * views[idx].projectionScale / distance);
+    }
+    return size;
+}
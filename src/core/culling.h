@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <glm/glm.hpp>
+#include "meshlet.h"
+
+struct SnapshotView;
+
+/// @brief Six planes bounding the volume a camera can see. Planes are normalized and point inwards
+struct Frustum{
+    //Left, right, bottom, top, near, far. xyz is the normal and w the distance
+    glm::vec4 planes[6];
+
+    /// @brief Extracts the planes of a view projection matrix
+    ///     The near plane is taken from the -w..w depth range, which also contains the 0..w range so the test stays conservative for either convention
+    /// @param viewProjectionMatrix The combined view and projection matrix
+    /// @return
+    static Frustum fromMatrix(const glm::mat4&);
+
+    /// @brief Returns false only if the sphere lies entirely outside one of the planes
+    /// @param center World space center of the sphere
+    /// @param radius Radius of the sphere
+    /// @return
+    bool intersectsSphere(glm::vec3, float) const;
+};
+
+/// @brief A snapshot view prepared for culling
+struct CullingView{
+    Frustum frustum;
+    //World space position of the camera
+    glm::vec3 position;
+    //1 if counter-clockwise triangles face the camera, -1 if the projection reverses the winding
+    float facing;
+    //Vertical scale of the projection. A sphere of radius r at distance d covers r * projectionScale / d of the view height
+    float projectionScale;
+};
+
+/// @brief A draw's model matrix prepared for culling its meshlets
+struct CullingInstance{
+    glm::mat4 modelMatrix;
+    //Largest axis scale of the model matrix; scales meshlet radii into world space
+    float maxScale;
+    //False for non-uniform scale, where object space normal cones don't survive the transform
+    bool coneUsable;
+    //1 unless the model matrix mirrors the mesh, which flips its winding
+    float facing;
+};
+
+/// @brief CPU side visibility tests for meshlets
+namespace Culling{
+    /// @brief Prepares a snapshot view for culling
+    /// @param view The view to prepare
+    /// @return
+    CullingView makeView(const SnapshotView&);
+
+    /// @brief Prepares a model matrix for culling
+    /// @param modelMatrix Object to world matrix of the draw. Must map the object space the meshlets were built in
+    /// @return
+    CullingInstance makeInstance(const glm::mat4&);
+
+    /// @brief Returns true if any of the meshlet's triangles could be front facing and inside the frustum of a view
+    /// @param meshlet The meshlet to test
+    /// @param instance The draw the meshlet belongs to
+    /// @param view The view to test against
+    /// @return
+    bool isMeshletVisible(const Meshlet&, const CullingInstance&, const CullingView&);
+
+    /// @brief Returns true if the meshlet is visible from any of the views
+    /// @param meshlet The meshlet to test
+    /// @param instance The draw the meshlet belongs to
+    /// @param views The views to test against
+    /// @param viewCount Number of views
+    /// @return
+    bool isMeshletVisible(const Meshlet&, const CullingInstance&, const CullingView*, size_t);
+
+    /// @brief Returns true if a sphere intersects the frustum of any of the views
+    /// @param center World space center of the sphere
+    /// @param radius World space radius of the sphere
+    /// @param views The views to test against
+    /// @param viewCount Number of views
+    /// @return
+    bool isSphereVisible(glm::vec3, float, const CullingView*, size_t);
+
+    /// @brief Returns the largest fraction of the view height a sphere covers in any of the views
+    /// @param center World space center of the sphere
+    /// @param radius World space radius of the sphere
+    /// @param views The views to measure in
+    /// @param viewCount Number of views
+    /// @return Returns infinity if a camera is inside the sphere and 0 if there are no views
+    float getProjectedSize(glm::vec3, float, const CullingView*, size_t);
+}
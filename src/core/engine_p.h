@@ -2,6 +2,8 @@
 
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
+#include <deque>
+#include <unordered_map>
 #include "engine.h"
 
 #include "renderer.h"
@@ -11,6 +13,13 @@
 #include "material.h"
 #include "mesh.h"
 #include "texture.h"
+#include "transformStore.h"
+#include "componentRegistry.h"
+#include "jobSystem.h"
+#include "renderThread.h"
+#include "message.h"
+#include "assetCache.h"
+#include "culling.h"
 
 class LightbringEngine::LightbringEngineImpl{
 public:
@@ -48,9 +57,120 @@ public:
     std::vector<Object*> objects;
     //List of all created materials
     std::vector<Material*> materials;
+    //Position of each material in the materials list. Written to the object buffer as the material index
+    std::unordered_map<const Material*, uint32_t> materialIndices;
     //List of all created cameras
     std::vector<Camera*> cameras;
 
+    //Structure-of-arrays storage backing every Transform handle
+    TransformStore transformStore;
+    //Sparse-set storage of the components attached to every object
+    ComponentRegistry componentRegistry;
+    //Worker threads shared by engine subsystems. Started with the engine
+    JobSystem jobSystem;
+    //Thread the renderer runs on. Fed a snapshot of the active scene every update
+    RenderThread renderThread;
+    //Messages posted to the main thread by workers. Drained once per update
+    MessageQueue messageQueue;
+    //Reference counted lookup of imported meshes and images
+    AssetCache assetCache;
+
+    /// @brief Asset whose last reference was released. Freed once the render thread has finished every snapshot that could reference it
+    struct PendingRelease{
+        Mesh* mesh;
+        Texture* texture;
+        //Id of the first snapshot taken after the release
+        uint64_t frameIndex;
+    };
+    //Released assets waiting to be freed
+    std::vector<PendingRelease> pendingReleases;
+
+    /// @brief Decoded asset waiting to be uploaded to the GPU. Uploads are spread over updates so imports finishing together don't stall one frame
+    struct PendingUpload{
+        Mesh* mesh;
+        Texture* texture;
+    };
+    //Uploads in the order their imports finished
+    std::deque<PendingUpload> pendingUploads;
+    //Bytes of asset data uploaded per update before the rest wait for the next one. At least one upload runs each update
+    static constexpr size_t UPLOAD_BYTES_PER_UPDATE = 16 << 20;
+    //Messages handled per update before the rest wait for the next one
+    static constexpr size_t MESSAGES_PER_UPDATE = 256;
+
+    //Static batches are split into cells of this size in world units so each can be culled on its own
+    static constexpr float STATIC_BATCH_CELL_SIZE = 64.0f;
+    //Batches are split further past this many vertices so they keep 16 bit indices
+    static constexpr size_t STATIC_BATCH_MAX_VERTICES = 65536;
+
+    /// @brief Pre-transformed geometry of the static objects in one cell that share a material
+    struct StaticBatch{
+        Mesh* mesh;
+        Material* material;
+        //Identity transform owning the batch's slot in the object buffer
+        Transform* transform;
+    };
+    //Batches built for the active scene
+    std::vector<StaticBatch> staticBatches;
+
+    //Values of sceneEntityFlags
+    static constexpr uint8_t SCENE_ENTITY_ABSENT = 0;
+    static constexpr uint8_t SCENE_ENTITY_PRESENT = 1;
+    //In the scene and drawn through a static batch rather than individually
+    static constexpr uint8_t SCENE_ENTITY_BATCHED = 2;
+    //Flag per entity describing its object's place in flaggedScene. Lets draws be gathered by walking the component pools' dense arrays
+    std::vector<uint8_t> sceneEntityFlags;
+    //Scene described by sceneEntityFlags and how many of its objects have been flagged. Scenes only ever gain objects
+    const Scene* flaggedScene;
+    size_t flaggedObjectCount;
+
+    //Projected sizes, as fractions of the view height, below which each further detail level is used
+    std::vector<float> lodThresholds;
+    //Fraction a projected size must pass a threshold by before an object's level changes
+    float lodHysteresis;
+
+    /// @brief Mesh and material last written to an object buffer slot. A slot is rewritten when either differs or its transform changed
+    struct ObjectSlotRecord{
+        const Mesh* mesh;
+        const Material* material;
+    };
+    //Indexed by transform id, which doubles as the object's slot in the renderer's object buffer
+    std::vector<ObjectSlotRecord> objectSlotRecords;
+    //Scratch list of the transform ids changed since the last snapshot
+    std::vector<TransformStore::Id> changedTransformIds;
+
+    /// @brief An object buffer write held until the render thread has rendered a snapshot containing it
+    struct PendingObjectUpdate{
+        SnapshotObjectUpdate update;
+        //Id of the latest snapshot the write was captured into
+        uint64_t frameIndex;
+    };
+    //Writes resent with every snapshot until acknowledged, as the render thread may skip snapshots
+    std::vector<PendingObjectUpdate> pendingObjectUpdates;
+    //Position of each slot's write in pendingObjectUpdates, UINT32_MAX if it has none. Indexed by slot
+    std::vector<uint32_t> pendingObjectUpdateIndices;
+
+    /// @brief A draw gathered from the active scene before its meshlets are culled
+    struct CullingDraw{
+        Mesh* mesh;
+        Material* material;
+        //Slot of the draw's data in the object buffer
+        uint32_t objectIndex;
+        CullingInstance instance;
+        //Index range of the selected detail level, drawn whole if the mesh has no meshlets
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        //Meshlets of the selected detail level within the mesh
+        const Meshlet* meshlets;
+        uint32_t meshletCount;
+        //Index of the draw's first meshlet in meshletVisibility
+        uint32_t firstMeshlet;
+    };
+    //Scratch storage reused by every snapshot's culling pass
+    std::vector<CullingView> cullingViews;
+    std::vector<CullingDraw> cullingDraws;
+    //One entry per meshlet of every gathered draw; non-zero if the meshlet is visible from any view
+    std::vector<uint8_t> meshletVisibility;
+
     LightbringEngineImpl();
     ~LightbringEngineImpl();
 
@@ -58,6 +178,61 @@ public:
 
     void initializeInput(GLFWwindow*);
 
+    /// @brief Handles a message drained from the message queue on the main thread
+    /// @param message The message to handle
+    void handleMessage(const Message&);
+
+    /// @brief Posts the result of an asset import to the main thread, handling it immediately if the caller is the main thread and the queue is full
+    /// @param type The type of message
+    /// @param payload The decoded asset
+    void postAssetMessage(MessageType, const AssetDecodedPayload&);
+
+    /// @brief Uploads queued decoded assets until the per update byte budget is spent
+    void processPendingUploads();
+
+    /// @brief Frees released assets that the render thread can no longer be reading
+    /// @param force If true every pending release is freed. Only valid once the render thread and workers have stopped
+    void processPendingReleases(bool = false);
+
+    /// @brief Captures the draws of the active scene into a snapshot. Meshlets are culled against the snapshot's views on the job system
+    ///     and each draw keeps the merged index ranges of its visible meshlets. Draws with nothing visible are dropped
+    /// @param snapshot The snapshot to fill. Its views must already be captured
+    void captureDraws(FrameSnapshot&);
+
+    /// @brief Writes an object's data to its object buffer slot if its transform, mesh or material changed since the slot was last written
+    /// @param slot The object's slot; the id of its transform
+    /// @param mesh The object's mesh
+    /// @param material The object's material. May be nullptr
+    /// @param modelMatrix The object's world matrix
+    /// @param center World space center of the object's bounding sphere
+    /// @param radius World space radius of the object's bounding sphere
+    /// @param frameIndex Id of the snapshot being captured
+    void writeObjectSlot(uint32_t, const Mesh*, const Material*, const glm::mat4&, glm::vec3, float, uint64_t);
+
+    /// @brief Copies every object buffer write the render thread hasn't acknowledged into a snapshot, dropping those it has
+    /// @param snapshot The snapshot to fill
+    void captureObjectUpdates(FrameSnapshot&);
+
+    /// @brief Merges the static objects of a scene into pre-transformed batches by material and world space cell and uploads them.
+    ///     Objects whose mesh is still importing or has no CPU side data are left to draw individually
+    /// @param scene The scene being activated
+    void buildStaticBatches(Scene*);
+
+    /// @brief Hands the current static batches to the pending releases so they are freed once the render thread is done with them
+    void releaseStaticBatches();
+
+    /// @brief Brings sceneEntityFlags up to date with a scene. Switching scenes reflags every object, otherwise only objects added since the last call
+    /// @param scene The scene to flag the objects of
+    void updateSceneEntityFlags(const Scene*);
+
+    /// @brief Selects the detail level of an object's mesh from its projected size in the current culling views
+    /// @param object The object being drawn. Its previously selected level is updated
+    /// @param mesh The object's mesh
+    /// @param center World space center of the object's bounding sphere
+    /// @param radius World space radius of the object's bounding sphere
+    /// @return Returns the level to draw; 0 for meshes without detail levels
+    uint32_t selectLodLevel(Object*, const Mesh*, glm::vec3, float);
+
     /// @brief Method used internally to respond to window resize event invocations
     /// @param width The new width of the window
     /// @param height The new height of the window
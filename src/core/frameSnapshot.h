@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+class Mesh;
+class Material;
+
+/// @brief A contiguous range of a mesh's index buffer that survived culling
+struct SnapshotRange{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+};
+
+/// @brief Per-object data kept in the renderer's object buffer. Matches the std430 layout of ObjectData in the vertex shader
+struct ObjectGpuData{
+    //Object to world matrix with the dequantization of the mesh's packed positions folded in
+    glm::mat4 modelMatrix;
+    //World space bounding sphere; xyz is the center and w the radius
+    glm::vec4 boundsSphere;
+    //Index of the object's material in creation order. UINT32_MAX if the object has no material
+    uint32_t materialIndex;
+    uint32_t padding[3];
+};
+static_assert(sizeof(ObjectGpuData) == 96, "ObjectGpuData must match the std430 layout of the shader's ObjectData");
+
+/// @brief A write to one slot of the renderer's object buffer
+struct SnapshotObjectUpdate{
+    uint32_t slot;
+    ObjectGpuData data;
+};
+
+/// @brief A single draw captured from the scene. Holds everything the renderer needs so it never touches live objects
+struct SnapshotDraw{
+    Mesh* mesh;
+    Material* material;
+    //Slot of the draw's data in the object buffer
+    uint32_t objectIndex;
+    //Index ranges to draw, stored in FrameSnapshot::ranges
+    uint32_t rangeOffset;
+    uint32_t rangeCount;
+};
+
+/// @brief Camera matrices captured from a rendering camera
+struct SnapshotView{
+    glm::mat4 viewMatrix;
+    glm::mat4 projectionMatrix;
+    glm::mat4 viewProjectionMatrix;
+};
+
+/// @brief Immutable description of a frame built by the main thread and consumed by the render thread
+///     Vectors are cleared rather than freed between frames so each snapshot slot acts as a reusable arena
+struct FrameSnapshot{
+    //Incrementing id of the simulation frame the snapshot was taken on
+    uint64_t frameIndex = 0;
+    //The primary rendering camera. Empty when no camera is rendering
+    std::vector<SnapshotView> views;
+    //Draws shared by every view
+    std::vector<SnapshotDraw> draws;
+    //Visible index ranges of every draw
+    std::vector<SnapshotRange> ranges;
+    //Object buffer slots written since the last snapshot the render thread rendered. Later entries for a slot replace earlier ones
+    std::vector<SnapshotObjectUpdate> objectUpdates;
+    //Number of slots the object buffer must hold
+    uint32_t objectCount = 0;
+
+    void clear(){
+        views.clear();
+        draws.clear();
+        ranges.clear();
+        objectUpdates.clear();
+        objectCount = 0;
+    }
+};
+
+/// @brief Single producer, single consumer triple buffer. The producer always has a slot to write to and the consumer always reads the most recently published slot
+///     Publishing and acquiring are a single atomic exchange so neither side ever waits on the other
+template<typename T>
+class TripleBuffer{
+public:
+    TripleBuffer() : writeIndex(0), readIndex(1), sharedState(2){}
+
+    /// @brief Returns the slot owned by the producer
+    /// @return
+    T& getWriteSlot(){
+        return slots[writeIndex];
+    }
+
+    /// @brief Hands the producer's slot to the consumer and takes back the shared slot. Producer only
+    void publish(){
+        writeIndex = sharedState.exchange(writeIndex | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    /// @brief Swaps in the most recently published slot if there is one. Consumer only
+    /// @return False if nothing has been published since the last call
+    bool acquire(){
+        if((sharedState.load(std::memory_order_relaxed) & FRESH_BIT) == 0)
+            return false;
+        readIndex = sharedState.exchange(readIndex, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    /// @brief Returns the slot owned by the consumer
+    /// @return
+    const T& getReadSlot() const{
+        return slots[readIndex];
+    }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    //Set on the shared state when it holds a slot the consumer hasn't seen
+    static constexpr uint8_t FRESH_BIT = 0x4;
+
+    T slots[3];
+    //Slot owned by the producer
+    uint8_t writeIndex;
+    //Slot owned by the consumer
+    uint8_t readIndex;
+    //Slot waiting to be swapped by either side, plus the fresh flag
+    alignas(64) std::atomic<uint8_t> sharedState;
+};
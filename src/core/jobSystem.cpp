@@ -0,0 +1,325 @@
+#include <iostream>
+#include "jobSystem.h"
+
+JobSystem* JobSystem::activeJobSystem = nullptr;
+
+namespace{
+    //Deque index owned by the current thread. -1 for threads the job system didn't register
+    thread_local int threadDequeIndex = -1;
+    //Job system the index belongs to
+    thread_local const JobSystem* threadOwner = nullptr;
+
+    //Number of times an idle worker retries before going to sleep
+    constexpr int IDLE_SPIN_COUNT = 64;
+}
+
+JobSystem::WorkStealingDeque::WorkStealingDeque() : top(0), bottom(0), buffer(new std::atomic<Job*>[CAPACITY]){
+    for(int64_t idx = 0; idx < CAPACITY; idx++)
+        buffer[idx].store(nullptr, std::memory_order_relaxed);
+}
+
+bool JobSystem::WorkStealingDeque::push(Job* job){
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    if(b - t >= CAPACITY)
+        return false;
+
+    buffer[b & MASK].store(job, std::memory_order_relaxed);
+    //Publish the job before the new bottom becomes visible to thieves
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return true;
+}
+
+JobSystem::Job* JobSystem::WorkStealingDeque::pop(){
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+
+    //Deque was empty
+    if(t > b){
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job* job = buffer[b & MASK].load(std::memory_order_relaxed);
+    if(t == b){
+        //Last job, race any thieves for it
+        if(!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            job = nullptr;
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+JobSystem::Job* JobSystem::WorkStealingDeque::steal(){
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_acquire);
+    if(t >= b)
+        return nullptr;
+
+    Job* job = buffer[t & MASK].load(std::memory_order_relaxed);
+    if(!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return nullptr;
+    return job;
+}
+
+JobSystem::JobSystem() : externalJobCount(0), backgroundJobCount(0), queuedJobs(0), runningJobs(0), sleepingWorkers(0), running(false){
+}
+
+JobSystem::~JobSystem(){
+    shutdown();
+    if(activeJobSystem == this)
+        activeJobSystem = nullptr;
+}
+
+JobSystem* JobSystem::getActive(){
+    return activeJobSystem;
+}
+
+void JobSystem::setActive(JobSystem* jobSystem){
+    activeJobSystem = jobSystem;
+}
+
+void JobSystem::initialize(uint32_t workerCount){
+    if(running.load())
+        return;
+
+    if(workerCount == 0){
+        uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+
+    //The initializing thread owns deque 0 so it can queue and help with jobs without locking
+    deques.clear();
+    for(uint32_t idx = 0; idx < workerCount + 1; idx++)
+        deques.push_back(std::make_unique<WorkStealingDeque>());
+    threadDequeIndex = 0;
+    threadOwner = this;
+
+    running.store(true);
+    for(uint32_t idx = 0; idx < workerCount; idx++)
+        workers.emplace_back(&JobSystem::workerLoop, this, idx + 1);
+}
+
+void JobSystem::shutdown(){
+    if(!running.load())
+        return;
+
+    //Drain anything still queued so counters held by callers complete. Background jobs are left to the workers
+    int threadIndex = getThreadIndex();
+    while(queuedJobs.load(std::memory_order_acquire) > 0){
+        Job* job = fetchJob(threadIndex >= 0 ? threadIndex : 0);
+        if(job != nullptr)
+            execute(job);
+        else
+            std::this_thread::yield();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        running.store(false);
+    }
+    sleepCondition.notify_all();
+
+    for(auto& worker : workers)
+        worker.join();
+    workers.clear();
+    deques.clear();
+
+    if(threadOwner == this){
+        threadDequeIndex = -1;
+        threadOwner = nullptr;
+    }
+}
+
+uint32_t JobSystem::getWorkerCount() const{
+    return static_cast<uint32_t>(workers.size());
+}
+
+void JobSystem::run(std::function<void()> task, JobCounter* counter, const JobCounter* dependency){
+    if(counter != nullptr)
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+    //Without workers jobs run immediately on the caller
+    if(workers.empty()){
+        Job job{std::move(task), counter, nullptr};
+        if(dependency != nullptr)
+            wait(*dependency);
+        runTask(job);
+        return;
+    }
+
+    enqueue(new Job{std::move(task), counter, dependency});
+}
+
+void JobSystem::runBackground(std::function<void()> task, JobCounter* counter){
+    if(workers.empty()){
+        run(std::move(task), counter);
+        return;
+    }
+
+    if(counter != nullptr)
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(externalMutex);
+        backgroundJobs.push_back(new Job{std::move(task), counter, nullptr});
+        backgroundJobCount.fetch_add(1, std::memory_order_release);
+    }
+
+    queuedJobs.fetch_add(1, std::memory_order_seq_cst);
+    if(sleepingWorkers.load(std::memory_order_seq_cst) > 0){
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        sleepCondition.notify_one();
+    }
+}
+
+bool JobSystem::isIdle() const{
+    //Fetched jobs are counted as running before they stop being counted as queued, so a job is never missed between the two
+    return queuedJobs.load(std::memory_order_acquire) == 0 && runningJobs.load(std::memory_order_acquire) == 0;
+}
+
+void JobSystem::wait(const JobCounter& counter){
+    int threadIndex = getThreadIndex();
+
+    while(!counter.isComplete()){
+        //Threads that own a deque help out instead of blocking
+        Job* job = fetchJob(threadIndex >= 0 ? threadIndex : 0);
+        if(job != nullptr)
+            execute(job);
+        else
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::workerLoop(uint32_t threadIndex){
+    threadDequeIndex = static_cast<int>(threadIndex);
+    threadOwner = this;
+
+    int idleSpins = 0;
+    while(true){
+        Job* job = fetchJob(threadIndex, true);
+        if(job != nullptr){
+            execute(job);
+            idleSpins = 0;
+            continue;
+        }
+
+        if(++idleSpins < IDLE_SPIN_COUNT){
+            std::this_thread::yield();
+            continue;
+        }
+
+        //Sleep until a job is queued. Queued jobs are counted before the lock is taken to notify, so a wakeup can't be missed
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        if(!running.load())
+            break;
+        sleepingWorkers.fetch_add(1);
+        sleepCondition.wait(lock, [this]() { return queuedJobs.load() > 0 || !running.load(); });
+        sleepingWorkers.fetch_sub(1);
+        if(!running.load())
+            break;
+        idleSpins = 0;
+    }
+}
+
+void JobSystem::enqueue(Job* job){
+    int threadIndex = getThreadIndex();
+    bool queued = false;
+
+    if(threadIndex >= 0)
+        queued = deques[threadIndex]->push(job);
+
+    //Unregistered threads and full deques fall back to the shared queue
+    if(!queued)
+        pushExternal(job);
+
+    queuedJobs.fetch_add(1, std::memory_order_seq_cst);
+    if(sleepingWorkers.load(std::memory_order_seq_cst) > 0){
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        sleepCondition.notify_one();
+    }
+}
+
+void JobSystem::pushExternal(Job* job){
+    std::lock_guard<std::mutex> lock(externalMutex);
+    externalJobs.push_back(job);
+    externalJobCount.fetch_add(1, std::memory_order_release);
+}
+
+JobSystem::Job* JobSystem::fetchJob(uint32_t threadIndex, bool allowBackground){
+    Job* job = nullptr;
+
+    //Own deque first, newest job is the most likely to be in cache
+    bool ownsDeque = getThreadIndex() == static_cast<int>(threadIndex);
+    if(ownsDeque)
+        job = deques[threadIndex]->pop();
+
+    //Only take the lock when the shared queue has something in it
+    if(job == nullptr && externalJobCount.load(std::memory_order_acquire) > 0){
+        std::lock_guard<std::mutex> lock(externalMutex);
+        if(!externalJobs.empty()){
+            job = externalJobs.front();
+            externalJobs.pop_front();
+            externalJobCount.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    //Steal the oldest job from the other threads, starting with the next one along to spread contention
+    uint32_t dequeCount = static_cast<uint32_t>(deques.size());
+    for(uint32_t offset = ownsDeque ? 1 : 0; job == nullptr && offset < dequeCount; offset++)
+        job = deques[(threadIndex + offset) % dequeCount]->steal();
+
+    //Background jobs last so they only run when there is no other work
+    if(job == nullptr && allowBackground && backgroundJobCount.load(std::memory_order_acquire) > 0){
+        std::lock_guard<std::mutex> lock(externalMutex);
+        if(!backgroundJobs.empty()){
+            job = backgroundJobs.front();
+            backgroundJobs.pop_front();
+            backgroundJobCount.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    if(job != nullptr){
+        runningJobs.fetch_add(1, std::memory_order_seq_cst);
+        queuedJobs.fetch_sub(1, std::memory_order_seq_cst);
+    }
+    return job;
+}
+
+void JobSystem::execute(Job* job){
+    //Dependency not met yet. Requeue on the shared queue rather than the bottom of this thread's deque, where the next pop would hand the
+    //same job straight back and the dependency queued beneath it could only run if another thread stole it
+    if(job->dependency != nullptr && !job->dependency->isComplete()){
+        pushExternal(job);
+        queuedJobs.fetch_add(1, std::memory_order_seq_cst);
+        runningJobs.fetch_sub(1, std::memory_order_release);
+        std::this_thread::yield();
+        return;
+    }
+
+    runTask(*job);
+    delete job;
+    runningJobs.fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::runTask(Job& job){
+    //A throwing task is reported and treated as complete so waits on its counter still finish and the worker keeps running
+    try{
+        job.task();
+    } catch(const std::exception& e){
+        std::cerr << "Job failed: " << e.what() << std::endl;
+    } catch(...){
+        std::cerr << "Job failed with an unknown exception" << std::endl;
+    }
+
+    if(job.counter != nullptr)
+        job.counter->pending.fetch_sub(1, std::memory_order_release);
+}
+
+int JobSystem::getThreadIndex() const{
+    return threadOwner == this ? threadDequeIndex : -1;
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// @brief Tracks the number of outstanding jobs in a group. Jobs decrement it as they complete
+class JobCounter{
+public:
+    JobCounter() : pending(0){}
+
+    /// @brief Returns true once every job tracked by the counter has completed
+    /// @return
+    bool isComplete() const{
+        return pending.load(std::memory_order_acquire) == 0;
+    }
+
+private:
+    friend class JobSystem;
+    std::atomic<int> pending;
+};
+
+/// @brief Work-stealing job system. Each worker thread owns a lock-free deque it pushes and pops from while idle workers steal from the others
+///     Threads waiting on a counter execute queued jobs rather than blocking
+class JobSystem{
+public:
+    JobSystem();
+    ~JobSystem();
+
+    /// @brief Returns the job system used by engine subsystems
+    /// @return
+    static JobSystem* getActive();
+
+    /// @brief Sets the job system used by engine subsystems
+    /// @param jobSystem The job system to make active
+    static void setActive(JobSystem*);
+
+    /// @brief Starts the worker threads. The calling thread is registered as the owner of the first deque
+    /// @param workerCount Number of worker threads. 0 uses one per hardware thread minus the caller
+    void initialize(uint32_t = 0);
+
+    /// @brief Finishes any queued jobs and stops the worker threads
+    void shutdown();
+
+    /// @brief Returns the number of worker threads
+    /// @return
+    uint32_t getWorkerCount() const;
+
+    /// @brief Queues a job
+    /// @param task The work to perform
+    /// @param counter Optional counter incremented now and decremented when the job completes
+    /// @param dependency Optional counter that must complete before the job is started
+    void run(std::function<void()>, JobCounter* = nullptr, const JobCounter* = nullptr);
+
+    /// @brief Queues a long running job such as an asset import. Only idle worker threads pick these up, never a thread helping out in wait,
+    ///     so a frame's parallel work can't end up stuck behind one. Runs immediately on the caller when there are no workers
+    /// @param task The work to perform
+    /// @param counter Optional counter incremented now and decremented when the job completes
+    void runBackground(std::function<void()>, JobCounter* = nullptr);
+
+    /// @brief Returns true when no jobs are queued or running
+    /// @return
+    bool isIdle() const;
+
+    /// @brief Executes queued jobs on the calling thread until the counter completes
+    /// @param counter The counter to wait on
+    void wait(const JobCounter&);
+
+    /// @brief Splits a range into batches executed across all threads and waits for them to finish
+    /// @param count Number of elements in the range
+    /// @param minBatchSize Smallest number of elements given to a single job
+    /// @param function Callable taking (uint32_t begin, uint32_t end)
+    template<typename Func>
+    void parallelFor(uint32_t count, uint32_t minBatchSize, const Func& function){
+        if(count == 0)
+            return;
+
+        //Aim for a few batches per thread so faster threads can steal the remainder
+        uint32_t threadCount = getWorkerCount() + 1;
+        uint32_t batchSize = count / (threadCount * 4);
+        if(batchSize < minBatchSize)
+            batchSize = minBatchSize;
+
+        //Too small to be worth splitting or no workers to split across
+        if(batchSize >= count || workers.empty()){
+            function(0, count);
+            return;
+        }
+
+        JobCounter counter;
+        for(uint32_t begin = 0; begin < count; begin += batchSize){
+            uint32_t end = begin + batchSize < count ? begin + batchSize : count;
+            run([&function, begin, end]() { function(begin, end); }, &counter);
+        }
+        wait(counter);
+    }
+
+private:
+    /// @brief Unit of queued work
+    struct Job{
+        std::function<void()> task;
+        JobCounter* counter;
+        const JobCounter* dependency;
+    };
+
+    /// @brief Fixed capacity Chase-Lev deque. The owning thread pushes and pops from the bottom, other threads steal from the top
+    class WorkStealingDeque{
+    public:
+        WorkStealingDeque();
+
+        /// @brief Pushes a job onto the bottom. Owner thread only
+        /// @return False if the deque is full
+        bool push(Job*);
+
+        /// @brief Pops a job from the bottom. Owner thread only
+        /// @return Nullptr if the deque is empty
+        Job* pop();
+
+        /// @brief Steals a job from the top. Any thread
+        /// @return Nullptr if the deque is empty or the steal lost a race
+        Job* steal();
+
+    private:
+        static constexpr int64_t CAPACITY = 4096;
+        static constexpr int64_t MASK = CAPACITY - 1;
+
+        alignas(64) std::atomic<int64_t> top;
+        alignas(64) std::atomic<int64_t> bottom;
+        std::unique_ptr<std::atomic<Job*>[]> buffer;
+    };
+
+    //Deque per thread. Index 0 belongs to the thread that initialized the system
+    std::vector<std::unique_ptr<WorkStealingDeque>> deques;
+    //Worker threads
+    std::vector<std::thread> workers;
+
+    //Jobs queued from threads that don't own a deque
+    std::deque<Job*> externalJobs;
+    std::mutex externalMutex;
+    std::atomic<size_t> externalJobCount;
+
+    //Long running jobs only taken by workers from their main loop. Guarded by externalMutex
+    std::deque<Job*> backgroundJobs;
+    std::atomic<size_t> backgroundJobCount;
+
+    //Number of queued jobs that haven't been started, including background jobs. Used to put idle workers to sleep
+    std::atomic<int> queuedJobs;
+    //Number of jobs fetched but not yet finished
+    std::atomic<int> runningJobs;
+    //Number of workers waiting on the condition variable
+    std::atomic<int> sleepingWorkers;
+    std::mutex sleepMutex;
+    std::condition_variable sleepCondition;
+
+    std::atomic<bool> running;
+
+    //Job system used by engine subsystems
+    static JobSystem* activeJobSystem;
+
+    /// @brief Main loop of a worker thread
+    /// @param threadIndex Index of the worker's deque
+    void workerLoop(uint32_t);
+
+    /// @brief Pushes a job onto the calling thread's deque, or the external queue if it doesn't own one
+    /// @param job The job to queue
+    void enqueue(Job*);
+
+    /// @brief Pushes a job onto the shared queue that every thread checks
+    /// @param job The job to queue
+    void pushExternal(Job*);
+
+    /// @brief Fetches the next job for a thread from its deque, the external queue, another thread's deque, or the background queue
+    /// @param threadIndex Index of the calling thread's deque
+    /// @param allowBackground True to fall back to background jobs. Only set by a worker's main loop
+    /// @return Nullptr if no job was found
+    Job* fetchJob(uint32_t, bool = false);
+
+    /// @brief Runs a job if its dependency is complete, otherwise requeues it
+    /// @param job The job to run
+    void execute(Job*);
+
+    /// @brief Runs a job's task and completes its counter. Exceptions thrown by the task are reported and not passed on
+    /// @param job The job to run
+    static void runTask(Job&);
+
+    /// @brief Returns the deque index owned by the calling thread
+    /// @return Returns -1 if the calling thread does not own a deque
+    int getThreadIndex() const;
+};
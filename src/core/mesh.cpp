@@ -1,8 +1,10 @@
+#include <cstring>
 #include "mesh.h"
 #include "rendererData.h"
+#include "vertexLayout.h"
 
 Mesh::Mesh() 
-    : pRendererData(std::make_unique<RendererData>()){
+    : pRendererData(std::make_unique<RendererData>()), mappedData{}, boundsMin(0.0f), boundsMax(0.0f), indexType(IndexType::INDEX_TYPE_UINT16), state(AssetState::ASSET_LOADED){
     type = ComponentType::COMP_MESH;
 
     pRendererData->rawData = nullptr;
@@ -10,23 +12,198 @@ Mesh::Mesh()
 }
 
 Mesh::Mesh(const Mesh& mesh)
-    : pRendererData(std::make_unique<RendererData>()){
+    : pRendererData(std::make_unique<RendererData>()), mappedData(mesh.mappedData), boundsMin(mesh.boundsMin), boundsMax(mesh.boundsMax), indexType(mesh.indexType), shortIndices(mesh.shortIndices), longIndices(mesh.longIndices), state(AssetState::ASSET_LOADED){
     type = ComponentType::COMP_MESH;
 
     vertices = mesh.vertices;
-    indices = mesh.indices;
+    meshlets = mesh.meshlets;
+    lods = mesh.lods;
 
     pRendererData->rawData = nullptr;
     pRendererData->rendererData = nullptr;
 }
 
 Mesh::Mesh(std::vector<Vertex> _vertices, std::vector<uint16_t> _indices, unsigned char* _data)
-    : pRendererData(std::make_unique<RendererData>()){
+    : pRendererData(std::make_unique<RendererData>()), mappedData{}, boundsMin(0.0f), boundsMax(0.0f), indexType(IndexType::INDEX_TYPE_UINT16), state(AssetState::ASSET_LOADED){
     type = ComponentType::COMP_MESH;
         
     vertices = _vertices;
-    indices = _indices;
+    shortIndices = _indices;
 
     pRendererData->rawData = _data;
     pRendererData->rendererData = nullptr;
-}
\ No newline at end of file
+    computeBounds();
+}
+
+AssetState Mesh::getState() const{
+    return state.load(std::memory_order_acquire);
+}
+
+void Mesh::setState(AssetState newState){
+    state.store(newState, std::memory_order_release);
+}
+void Mesh::writeVertexData(void* destination) const{
+    if(mappedData.owner){
+        std::memcpy(destination, mappedData.vertexData, mappedData.vertexDataSize);
+        return;
+    }
+
+    //Positions are stored as a fraction of the bounds. A flat axis has every position at its minimum
+    glm::vec3 extent = boundsMax - boundsMin;
+    glm::vec3 inverseExtent(extent.x > 0.0f ? 1.0f / extent.x : 0.0f, extent.y > 0.0f ? 1.0f / extent.y : 0.0f, extent.z > 0.0f ? 1.0f / extent.z : 0.0f);
+
+    unsigned char* output = static_cast<unsigned char*>(destination);
+    for(const auto& vertex : vertices){
+        VertexPacking::writeVertex<PackedVertexLayout>(vertex, boundsMin, inverseExtent, output);
+        output += PackedVertexLayout::stride;
+    }
+}
+
+size_t Mesh::getVertexDataSize() const{
+    return mappedData.owner ? mappedData.vertexDataSize : vertices.size() * PackedVertexLayout::stride;
+}
+
+uint32_t Mesh::getVertexStride() const{
+    return PackedVertexLayout::stride;
+}
+
+glm::mat4 Mesh::getDequantizationMatrix() const{
+    glm::vec3 extent = boundsMax - boundsMin;
+    glm::mat4 output(1.0f);
+    output[0][0] = extent.x;
+    output[1][1] = extent.y;
+    output[2][2] = extent.z;
+    output[3] = glm::vec4(boundsMin, 1.0f);
+    return output;
+}
+
+size_t Mesh::getVertexCount() const{
+    return mappedData.owner ? mappedData.vertexCount : vertices.size();
+}
+
+Vertex Mesh::getVertex(size_t index) const{
+    if(mappedData.owner){
+        const unsigned char* packed = static_cast<const unsigned char*>(mappedData.vertexData) + index * PackedVertexLayout::stride;
+        return VertexPacking::readVertex<PackedVertexLayout>(packed, boundsMin, boundsMax - boundsMin);
+    }
+    return vertices[index];
+}
+
+void Mesh::setIndices(const std::vector<uint32_t>& indices){
+    setIndices(indices.data(), indices.size());
+}
+
+void Mesh::setIndices(const uint32_t* indices, size_t count){
+    uint32_t maxIndex = 0;
+    for(size_t idx = 0; idx < count; idx++){
+        if(indices[idx] > maxIndex)
+            maxIndex = indices[idx];
+    }
+
+    shortIndices.clear();
+    longIndices.clear();
+    if(maxIndex <= UINT16_MAX){
+        indexType = IndexType::INDEX_TYPE_UINT16;
+        shortIndices.assign(indices, indices + count);
+    }
+    else{
+        indexType = IndexType::INDEX_TYPE_UINT32;
+        longIndices.assign(indices, indices + count);
+    }
+}
+
+std::vector<uint32_t> Mesh::getIndices() const{
+    std::vector<uint32_t> output(getIndexCount());
+    for(size_t idx = 0; idx < output.size(); idx++)
+        output[idx] = getIndex(idx);
+    return output;
+}
+
+uint32_t Mesh::getIndex(size_t position) const{
+    //Mapped data has no alignment guarantee beyond the file's blob alignment, so read it by copy
+    const unsigned char* data = static_cast<const unsigned char*>(getIndexData());
+    if(getIndexType() == IndexType::INDEX_TYPE_UINT32){
+        uint32_t index;
+        std::memcpy(&index, data + position * sizeof(uint32_t), sizeof(uint32_t));
+        return index;
+    }
+    uint16_t index;
+    std::memcpy(&index, data + position * sizeof(uint16_t), sizeof(uint16_t));
+    return index;
+}
+
+IndexType Mesh::getIndexType() const{
+    return mappedData.owner ? mappedData.indexType : indexType;
+}
+
+const void* Mesh::getIndexData() const{
+    if(mappedData.owner)
+        return mappedData.indexData;
+    return indexType == IndexType::INDEX_TYPE_UINT32 ? static_cast<const void*>(longIndices.data()) : static_cast<const void*>(shortIndices.data());
+}
+
+size_t Mesh::getIndexDataSize() const{
+    if(mappedData.owner)
+        return mappedData.indexDataSize;
+    return indexType == IndexType::INDEX_TYPE_UINT32 ? longIndices.size() * sizeof(uint32_t) : shortIndices.size() * sizeof(uint16_t);
+}
+
+uint32_t Mesh::getIndexCount() const{
+    if(mappedData.owner)
+        return static_cast<uint32_t>(mappedData.indexCount);
+    return static_cast<uint32_t>(indexType == IndexType::INDEX_TYPE_UINT32 ? longIndices.size() : shortIndices.size());
+}
+
+const Meshlet* Mesh::getMeshlets() const{
+    return mappedData.owner ? mappedData.meshletData : meshlets.data();
+}
+
+size_t Mesh::getMeshletCount() const{
+    return mappedData.owner ? mappedData.meshletCount : meshlets.size();
+}
+
+const MeshLod* Mesh::getLods() const{
+    return mappedData.owner ? mappedData.lodData : lods.data();
+}
+
+size_t Mesh::getLodCount() const{
+    return mappedData.owner ? mappedData.lodCount : lods.size();
+}
+
+void Mesh::computeBounds(){
+    //Mapped vertices are packed against the bounds stored in the cooked file
+    if(mappedData.owner)
+        return;
+
+    if(vertices.empty()){
+        boundsMin = glm::vec3(0.0f);
+        boundsMax = glm::vec3(0.0f);
+        return;
+    }
+
+    boundsMin = vertices[0].position;
+    boundsMax = vertices[0].position;
+    for(const auto& vertex : vertices){
+        boundsMin = glm::min(boundsMin, vertex.position);
+        boundsMax = glm::max(boundsMax, vertex.position);
+    }
+}
+
+void Mesh::takeGeometry(Mesh& source){
+    vertices = std::move(source.vertices);
+    meshlets = std::move(source.meshlets);
+    lods = std::move(source.lods);
+    indexType = source.indexType;
+    shortIndices = std::move(source.shortIndices);
+    longIndices = std::move(source.longIndices);
+    mappedData = std::move(source.mappedData);
+    boundsMin = source.boundsMin;
+    boundsMax = source.boundsMax;
+
+    source.vertices.clear();
+    source.meshlets.clear();
+    source.lods.clear();
+    source.shortIndices.clear();
+    source.longIndices.clear();
+    source.mappedData = MeshSourceView{};
+}
@@ -0,0 +1,426 @@
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include "meshOptimizer.h"
+#include "mesh.h"
+
+namespace{
+    //Marks an empty hash table entry or an unassigned vertex
+    constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+    /// @brief Hashes the bytes of a vertex with 32 bit FNV-1a
+    uint32_t hashVertex(const Vertex& vertex){
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&vertex);
+        uint32_t hash = 2166136261u;
+        for(size_t idx = 0; idx < sizeof(Vertex); idx++){
+            hash ^= bytes[idx];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    //Forsyth scoring constants
+    constexpr float CACHE_DECAY_POWER = 1.5f;
+    constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+    constexpr float VALENCE_BOOST_SCALE = 2.0f;
+    constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+    /// @brief Scores a vertex by its position in the cache and the number of triangles still using it
+    /// @param cachePosition Position in the cache, -1 if not cached
+    /// @param remainingTriangles Number of triangles that haven't been emitted that use the vertex
+    float scoreVertex(int cachePosition, uint32_t remainingTriangles){
+        //Nothing left to draw with the vertex
+        if(remainingTriangles == 0)
+            return -1.0f;
+
+        float score = 0.0f;
+        if(cachePosition >= 0){
+            //Vertices of the last triangle get a fixed score so the next triangle doesn't just repeat its edge order
+            if(cachePosition < 3)
+                score = LAST_TRIANGLE_SCORE;
+            else{
+                const float scaler = 1.0f / (MeshOptimizer::CACHE_SIZE - 3);
+                score = std::pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+            }
+        }
+
+        //Boost vertices with few triangles left so they are finished off and don't linger
+        score += VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+        return score;
+    }
+}
+
+void MeshOptimizer::weldVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices){
+    //Open addressing table of unique vertex ids, kept at most half full
+    size_t tableSize = 1;
+    while(tableSize < vertices.size() * 2)
+        tableSize <<= 1;
+    std::vector<uint32_t> table(tableSize, INVALID_INDEX);
+    size_t tableMask = tableSize - 1;
+
+    std::vector<Vertex> unique;
+    unique.reserve(vertices.size());
+    //Unique id of every input vertex
+    std::vector<uint32_t> remap(vertices.size(), INVALID_INDEX);
+
+    for(size_t idx = 0; idx < vertices.size(); idx++){
+        const Vertex& vertex = vertices[idx];
+        size_t slot = hashVertex(vertex) & tableMask;
+
+        //Probe until the vertex or an empty entry is found
+        while(table[slot] != INVALID_INDEX && std::memcmp(&unique[table[slot]], &vertex, sizeof(Vertex)) != 0)
+            slot = (slot + 1) & tableMask;
+
+        if(table[slot] == INVALID_INDEX){
+            table[slot] = static_cast<uint32_t>(unique.size());
+            unique.push_back(vertex);
+        }
+        remap[idx] = table[slot];
+    }
+
+    for(auto& index : indices)
+        index = remap[index];
+    vertices.swap(unique);
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount){
+    size_t triangleCount = indices.size() / 3;
+    if(triangleCount == 0)
+        return;
+
+    //Build the list of triangles using each vertex
+    std::vector<uint32_t> remainingTriangles(vertexCount, 0);
+    for(auto index : indices)
+        remainingTriangles[index]++;
+
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for(size_t vertex = 0; vertex < vertexCount; vertex++)
+        adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + remainingTriangles[vertex];
+
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for(size_t triangle = 0; triangle < triangleCount; triangle++){
+        for(int corner = 0; corner < 3; corner++){
+            uint32_t vertex = indices[triangle * 3 + corner];
+            adjacency[fill[vertex]++] = static_cast<uint32_t>(triangle);
+        }
+    }
+
+    //Initial scores with an empty cache
+    std::vector<int> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for(size_t vertex = 0; vertex < vertexCount; vertex++)
+        vertexScores[vertex] = scoreVertex(-1, remainingTriangles[vertex]);
+
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    uint32_t bestTriangle = INVALID_INDEX;
+    float bestScore = -1.0f;
+    for(size_t triangle = 0; triangle < triangleCount; triangle++){
+        triangleScores[triangle] = vertexScores[indices[triangle * 3]] + vertexScores[indices[triangle * 3 + 1]] + vertexScores[indices[triangle * 3 + 2]];
+        if(triangleScores[triangle] > bestScore){
+            bestScore = triangleScores[triangle];
+            bestTriangle = static_cast<uint32_t>(triangle);
+        }
+    }
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+
+    //Cache holds CACHE_SIZE entries plus room for the three vertices pushed in by each triangle
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> nextCache;
+    cache.reserve(CACHE_SIZE + 3);
+    nextCache.reserve(CACHE_SIZE + 3);
+
+    //Scan position used when no cached vertex has a remaining triangle
+    size_t scanCursor = 0;
+
+    for(size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++){
+        if(bestTriangle == INVALID_INDEX){
+            while(emitted[scanCursor])
+                scanCursor++;
+            bestTriangle = static_cast<uint32_t>(scanCursor);
+        }
+
+        const uint32_t* triangleVertices = &indices[bestTriangle * 3];
+        output.insert(output.end(), triangleVertices, triangleVertices + 3);
+        emitted[bestTriangle] = true;
+
+        //Remove the triangle from the adjacency of its vertices
+        for(int corner = 0; corner < 3; corner++){
+            uint32_t vertex = triangleVertices[corner];
+            uint32_t* begin = &adjacency[adjacencyOffsets[vertex]];
+            uint32_t* end = begin + remainingTriangles[vertex];
+            for(uint32_t* entry = begin; entry < end; entry++){
+                if(*entry == bestTriangle){
+                    *entry = *(end - 1);
+                    remainingTriangles[vertex]--;
+                    break;
+                }
+            }
+        }
+
+        //Push the triangle's vertices to the front of the cache
+        nextCache.assign(triangleVertices, triangleVertices + 3);
+        for(auto vertex : cache){
+            if(vertex != triangleVertices[0] && vertex != triangleVertices[1] && vertex != triangleVertices[2])
+                nextCache.push_back(vertex);
+        }
+
+        //Rescore everything that moved, including vertices that fell out of the cache
+        for(size_t position = 0; position < nextCache.size(); position++){
+            uint32_t vertex = nextCache[position];
+            cachePositions[vertex] = position < CACHE_SIZE ? static_cast<int>(position) : -1;
+            vertexScores[vertex] = scoreVertex(cachePositions[vertex], remainingTriangles[vertex]);
+        }
+
+        //Update the triangles touching the cache and pick the best of them for the next step
+        bestTriangle = INVALID_INDEX;
+        bestScore = -1.0f;
+        for(auto vertex : nextCache){
+            uint32_t begin = adjacencyOffsets[vertex];
+            uint32_t end = begin + remainingTriangles[vertex];
+            for(uint32_t entry = begin; entry < end; entry++){
+                uint32_t triangle = adjacency[entry];
+                float score = vertexScores[indices[triangle * 3]] + vertexScores[indices[triangle * 3 + 1]] + vertexScores[indices[triangle * 3 + 2]];
+                triangleScores[triangle] = score;
+                if(score > bestScore){
+                    bestScore = score;
+                    bestTriangle = triangle;
+                }
+            }
+        }
+
+        if(nextCache.size() > CACHE_SIZE)
+            nextCache.resize(CACHE_SIZE);
+        cache.swap(nextCache);
+    }
+
+    indices.swap(output);
+}
+
+void MeshOptimizer::optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices){
+    std::vector<uint32_t> remap(vertices.size(), INVALID_INDEX);
+    std::vector<Vertex> reordered;
+    reordered.reserve(vertices.size());
+
+    for(auto& index : indices){
+        if(remap[index] == INVALID_INDEX){
+            remap[index] = static_cast<uint32_t>(reordered.size());
+            reordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    vertices.swap(reordered);
+}
+
+std::vector<Meshlet> MeshOptimizer::buildMeshlets(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices){
+    std::vector<Meshlet> meshlets;
+    size_t triangleCount = indices.size() / 3;
+    if(triangleCount == 0)
+        return meshlets;
+
+    //Id of the last meshlet each vertex was counted in, offset by one so 0 means never
+    std::vector<uint32_t> lastMeshlet(vertices.size(), 0);
+    uint32_t meshletId = 1;
+
+    Meshlet current{};
+    uint32_t currentTriangles = 0;
+
+    auto finish = [&](size_t endTriangle){
+        size_t beginTriangle = current.firstIndex / 3;
+
+        //Bounding sphere around the center of the meshlet's box
+        glm::vec3 boxMin = vertices[indices[current.firstIndex]].position;
+        glm::vec3 boxMax = boxMin;
+        for(size_t idx = current.firstIndex; idx < endTriangle * 3; idx++){
+            boxMin = glm::min(boxMin, vertices[indices[idx]].position);
+            boxMax = glm::max(boxMax, vertices[indices[idx]].position);
+        }
+        current.center = (boxMin + boxMax) * 0.5f;
+        float radiusSquared = 0.0f;
+        for(size_t idx = current.firstIndex; idx < endTriangle * 3; idx++){
+            glm::vec3 offset = vertices[indices[idx]].position - current.center;
+            float distanceSquared = offset.x * offset.x + offset.y * offset.y + offset.z * offset.z;
+            if(distanceSquared > radiusSquared)
+                radiusSquared = distanceSquared;
+        }
+        current.radius = std::sqrt(radiusSquared);
+
+        //Normal cone around the average of the counter-clockwise triangle normals
+        std::vector<glm::vec3> normals;
+        normals.reserve(endTriangle - beginTriangle);
+        glm::vec3 axis(0.0f);
+        for(size_t triangle = beginTriangle; triangle < endTriangle; triangle++){
+            glm::vec3 a = vertices[indices[triangle * 3]].position;
+            glm::vec3 b = vertices[indices[triangle * 3 + 1]].position;
+            glm::vec3 c = vertices[indices[triangle * 3 + 2]].position;
+            glm::vec3 edge0 = b - a;
+            glm::vec3 edge1 = c - a;
+            glm::vec3 normal(edge0.y * edge1.z - edge0.z * edge1.y, edge0.z * edge1.x - edge0.x * edge1.z, edge0.x * edge1.y - edge0.y * edge1.x);
+            float length = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+            //Degenerate triangles have no facing and can't be culled by it
+            if(length == 0.0f)
+                continue;
+            normal = normal / length;
+            normals.push_back(normal);
+            axis += normal;
+        }
+
+        float axisLength = std::sqrt(axis.x * axis.x + axis.y * axis.y + axis.z * axis.z);
+        current.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+        current.coneCos = -1.0f;
+        current.coneSin = 0.0f;
+        if(axisLength > 0.0f && !normals.empty()){
+            current.coneAxis = axis / axisLength;
+            float minimumDot = 1.0f;
+            for(const auto& normal : normals){
+                float dot = normal.x * current.coneAxis.x + normal.y * current.coneAxis.y + normal.z * current.coneAxis.z;
+                if(dot < minimumDot)
+                    minimumDot = dot;
+            }
+            current.coneCos = minimumDot;
+            current.coneSin = std::sqrt(std::max(0.0f, 1.0f - minimumDot * minimumDot));
+        }
+
+        meshlets.push_back(current);
+    };
+
+    current.firstIndex = 0;
+    for(size_t triangle = 0; triangle < triangleCount; triangle++){
+        //Count the vertices the triangle would add
+        uint32_t newVertices = 0;
+        for(int corner = 0; corner < 3; corner++){
+            uint32_t vertex = indices[triangle * 3 + corner];
+            if(lastMeshlet[vertex] != meshletId){
+                bool repeated = false;
+                for(int previous = 0; previous < corner; previous++)
+                    repeated |= indices[triangle * 3 + previous] == vertex;
+                if(!repeated)
+                    newVertices++;
+            }
+        }
+
+        //Start a new meshlet when the triangle doesn't fit
+        if(currentTriangles > 0 && (current.vertexCount + newVertices > MESHLET_MAX_VERTICES || currentTriangles + 1 > MESHLET_MAX_TRIANGLES)){
+            finish(triangle);
+            meshletId++;
+            current = Meshlet{};
+            current.firstIndex = static_cast<uint32_t>(triangle * 3);
+            currentTriangles = 0;
+            triangle--;
+            continue;
+        }
+
+        for(int corner = 0; corner < 3; corner++)
+            lastMeshlet[indices[triangle * 3 + corner]] = meshletId;
+        current.vertexCount += newVertices;
+        current.indexCount += 3;
+        currentTriangles++;
+    }
+    finish(triangleCount);
+
+    return meshlets;
+}
+
+float MeshOptimizer::calculateACMR(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize){
+    size_t triangleCount = indices.size() / 3;
+    if(triangleCount == 0)
+        return 0.0f;
+
+    //Time each vertex entered the FIFO. A vertex is cached while it entered within the last cacheSize misses
+    std::vector<size_t> insertedAt(vertexCount, 0);
+    size_t missCount = 0;
+    for(auto index : indices){
+        if(insertedAt[index] == 0 || missCount - insertedAt[index] >= cacheSize){
+            missCount++;
+            insertedAt[index] = missCount;
+        }
+    }
+
+    return static_cast<float>(missCount) / static_cast<float>(triangleCount);
+}
+
+MeshOptimizationStats MeshOptimizer::optimizeMesh(Mesh* mesh){
+    MeshOptimizationStats stats{mesh->getVertexCount(), mesh->getVertexCount(), 0.0f, 0.0f, mesh->getLodCount()};
+
+    //Mapped meshes come from a cooked file and were optimized before being written
+    if(mesh->mappedData.owner)
+        return stats;
+
+    std::vector<uint32_t> indices = mesh->getIndices();
+    std::vector<Vertex>& vertices = mesh->vertices;
+    stats.acmrBefore = calculateACMR(indices, vertices.size());
+
+    weldVertices(vertices, indices);
+    optimizeVertexCache(indices, vertices.size());
+    optimizeVertexFetch(vertices, indices);
+
+    stats.outputVertexCount = vertices.size();
+    stats.acmrAfter = calculateACMR(indices, vertices.size());
+
+    //Errors are stored relative to the mesh size so levels can be compared across meshes
+    glm::vec3 boundsMin = vertices.empty() ? glm::vec3(0.0f) : vertices[0].position;
+    glm::vec3 boundsMax = boundsMin;
+    for(const auto& vertex : vertices){
+        boundsMin = glm::min(boundsMin, vertex.position);
+        boundsMax = glm::max(boundsMax, vertex.position);
+    }
+    float diagonal = glm::length(boundsMax - boundsMin);
+
+    //Simplify each level from the one before it. Errors add up along the chain
+    std::vector<std::vector<uint32_t>> levels;
+    std::vector<float> levelErrors;
+    levels.push_back(std::move(indices));
+    levelErrors.push_back(0.0f);
+    while(levels.size() < LOD_MAX_LEVELS){
+        const std::vector<uint32_t>& previous = levels.back();
+        if(previous.size() / 3 < LOD_MIN_TRIANGLES * 2)
+            break;
+
+        size_t target = static_cast<size_t>(previous.size() / 3 * LOD_REDUCTION) * 3;
+        float error = 0.0f;
+        std::vector<uint32_t> simplified = simplify(vertices, previous, target, &error);
+        if(simplified.empty() || simplified.size() > previous.size() * LOD_MIN_REDUCTION)
+            break;
+
+        optimizeVertexCache(simplified, vertices.size());
+        levelErrors.push_back(levelErrors.back() + (diagonal > 0.0f ? error / diagonal : 0.0f));
+        levels.push_back(std::move(simplified));
+    }
+
+    //Pack every level into one index buffer, each with its own meshlets
+    indices.clear();
+    mesh->meshlets.clear();
+    mesh->lods.clear();
+    for(size_t level = 0; level < levels.size(); level++){
+        MeshLod lod;
+        lod.firstIndex = static_cast<uint32_t>(indices.size());
+        lod.indexCount = static_cast<uint32_t>(levels[level].size());
+        lod.firstMeshlet = static_cast<uint32_t>(mesh->meshlets.size());
+        lod.error = levelErrors[level];
+
+        for(Meshlet meshlet : buildMeshlets(vertices, levels[level])){
+            meshlet.firstIndex += lod.firstIndex;
+            mesh->meshlets.push_back(meshlet);
+        }
+        lod.meshletCount = static_cast<uint32_t>(mesh->meshlets.size()) - lod.firstMeshlet;
+
+        indices.insert(indices.end(), levels[level].begin(), levels[level].end());
+        mesh->lods.push_back(lod);
+    }
+    stats.lodCount = mesh->lods.size();
+
+    //Welding usually brings large scans back under the 16 bit limit
+    mesh->setIndices(indices);
+
+    #ifdef DEBUG_LOG_MESH_OPTIMIZATION
+    std::cout << "Mesh optimization: " << stats.inputVertexCount << " -> " << stats.outputVertexCount << " vertices, ACMR "
+        << stats.acmrBefore << " -> " << stats.acmrAfter << ", " << stats.lodCount << " detail levels" << std::endl;
+    #endif
+
+    return stats;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "vertex.h"
+#include "meshlet.h"
+#include "meshLod.h"
+
+class Mesh;
+
+/// @brief Results of optimizing a mesh
+struct MeshOptimizationStats{
+    //Vertex count before and after welding
+    size_t inputVertexCount;
+    size_t outputVertexCount;
+    //Average cache miss ratio (vertex shader invocations per triangle) before and after optimizing
+    float acmrBefore;
+    float acmrAfter;
+    //Number of detail levels generated, including the full resolution level
+    size_t lodCount;
+};
+
+/// @brief Import post-processing that makes index buffers worth having
+namespace MeshOptimizer{
+    //Size of the simulated post-transform cache used for triangle ordering and ACMR
+    static constexpr uint32_t CACHE_SIZE = 32;
+    //Limits of a single meshlet
+    static constexpr uint32_t MESHLET_MAX_VERTICES = 64;
+    static constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+    //Maximum number of detail levels, including the full resolution level
+    static constexpr uint32_t LOD_MAX_LEVELS = 5;
+    //Fraction of the previous level's triangles each level aims for
+    static constexpr float LOD_REDUCTION = 0.5f;
+    //A level that can't get below this fraction of the previous level isn't worth the index memory
+    static constexpr float LOD_MIN_REDUCTION = 0.85f;
+    //Meshes below this many triangles don't get further levels
+    static constexpr uint32_t LOD_MIN_TRIANGLES = 64;
+
+    /// @brief Merges vertices with identical contents
+    /// @param vertices The vertices to weld. Replaced with the unique vertices
+    /// @param indices Indices into vertices. Remapped to the unique vertices
+    void weldVertices(std::vector<Vertex>&, std::vector<uint32_t>&);
+
+    /// @brief Reorders triangles so consecutive triangles reuse recently transformed vertices. Uses Forsyth's linear-speed algorithm
+    /// @param indices Triangle list to reorder in place
+    /// @param vertexCount Number of vertices referenced by the indices
+    void optimizeVertexCache(std::vector<uint32_t>&, size_t);
+
+    /// @brief Reorders vertices into the order they are first referenced so fetches walk memory forwards. Unreferenced vertices are removed
+    /// @param vertices The vertices to reorder
+    /// @param indices Indices into vertices. Remapped to the new order
+    void optimizeVertexFetch(std::vector<Vertex>&, std::vector<uint32_t>&);
+
+    /// @brief Splits a triangle list into meshlets of consecutive triangles. Run after optimizeVertexCache so neighbouring triangles are adjacent in the list
+    /// @param vertices The vertices referenced by the indices
+    /// @param indices Triangle list to split
+    /// @return Returns meshlets with bounding spheres and normal cones
+    std::vector<Meshlet> buildMeshlets(const std::vector<Vertex>&, const std::vector<uint32_t>&);
+
+    /// @brief Reduces a triangle list by collapsing edges in order of their quadric error. Collapses move a vertex onto a neighbour,
+    ///     so the result indexes the same vertices. Open borders only collapse along themselves and vertices on attribute seams never move
+    /// @param vertices The vertices referenced by the indices
+    /// @param indices Triangle list to simplify
+    /// @param targetIndexCount Index count to stop at. May not be reached if every remaining collapse is disallowed
+    /// @param resultError Optional output of the largest collapse error, as a distance in the units of the positions
+    /// @return Returns the simplified triangle list
+    std::vector<uint32_t> simplify(const std::vector<Vertex>&, const std::vector<uint32_t>&, size_t, float* = nullptr);
+
+    /// @brief Simulates a FIFO post-transform cache and returns the average number of cache misses per triangle
+    /// @param indices Triangle list to measure
+    /// @param vertexCount Number of vertices referenced by the indices
+    /// @param cacheSize Number of entries in the simulated cache
+    /// @return Returns 0 for an empty triangle list
+    float calculateACMR(const std::vector<uint32_t>&, size_t, uint32_t = CACHE_SIZE);
+
+    /// @brief Welds, cache optimizes and fetch optimizes a mesh's vertices and indices in place, then generates its detail levels and builds the meshlets of each. Meshes read from a mapped file are left untouched
+    ///     Statistics are logged when DEBUG_LOG_MESH_OPTIMIZATION is defined
+    /// @param mesh The mesh to optimize
+    /// @return
+    MeshOptimizationStats optimizeMesh(Mesh*);
+}
@@ -0,0 +1,382 @@
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+#include "meshOptimizer.h"
+
+namespace{
+    //Scales the quadrics that keep open borders in place relative to the surface quadrics
+    constexpr float BORDER_WEIGHT = 10.0f;
+    //Minimum cosine between a triangle's normal before and after a collapse, scaled by both normal lengths
+    constexpr float FLIP_THRESHOLD = 1e-2f;
+
+    /// @brief Symmetric 4x4 matrix accumulating the weighted squared distance to a set of planes
+    struct Quadric{
+        float a00, a11, a22;
+        float a01, a02, a12;
+        float b0, b1, b2;
+        float c;
+        //Sum of the plane weights; divides the error back into squared distance
+        float weight;
+    };
+
+    /// @brief Builds the quadric of a single plane
+    /// @param normal Unit normal of the plane
+    /// @param distance Plane offset so that dot(normal, p) + distance = 0
+    /// @param weight Importance of the plane
+    Quadric makePlaneQuadric(glm::vec3 normal, float distance, float weight){
+        Quadric quadric;
+        quadric.a00 = normal.x * normal.x * weight;
+        quadric.a11 = normal.y * normal.y * weight;
+        quadric.a22 = normal.z * normal.z * weight;
+        quadric.a01 = normal.x * normal.y * weight;
+        quadric.a02 = normal.x * normal.z * weight;
+        quadric.a12 = normal.y * normal.z * weight;
+        quadric.b0 = normal.x * distance * weight;
+        quadric.b1 = normal.y * distance * weight;
+        quadric.b2 = normal.z * distance * weight;
+        quadric.c = distance * distance * weight;
+        quadric.weight = weight;
+        return quadric;
+    }
+
+    void addQuadric(Quadric& destination, const Quadric& source){
+        destination.a00 += source.a00;
+        destination.a11 += source.a11;
+        destination.a22 += source.a22;
+        destination.a01 += source.a01;
+        destination.a02 += source.a02;
+        destination.a12 += source.a12;
+        destination.b0 += source.b0;
+        destination.b1 += source.b1;
+        destination.b2 += source.b2;
+        destination.c += source.c;
+        destination.weight += source.weight;
+    }
+
+    /// @brief Returns the weighted mean squared distance from a point to the quadric's planes
+    float evaluateQuadric(const Quadric& quadric, glm::vec3 point){
+        float error = point.x * (quadric.a00 * point.x + 2.0f * (quadric.a01 * point.y + quadric.a02 * point.z + quadric.b0))
+            + point.y * (quadric.a11 * point.y + 2.0f * (quadric.a12 * point.z + quadric.b1))
+            + point.z * (quadric.a22 * point.z + 2.0f * quadric.b2)
+            + quadric.c;
+        return quadric.weight > 0.0f ? std::fabs(error) / quadric.weight : 0.0f;
+    }
+
+    /// @brief How a vertex may move during simplification
+    enum VertexKind : uint8_t{
+        //Interior vertex; may collapse along any edge
+        KIND_MANIFOLD,
+        //On an open border; may only collapse along the border
+        KIND_BORDER,
+        //One of two vertices sharing a position along an attribute seam, eg. a UV chart border. Collapses along the seam together with its partner
+        KIND_SEAM,
+        //Shares its position in a way a paired collapse can't keep closed, eg. where seams meet. Never moves so the seam can't tear
+        KIND_LOCKED
+    };
+
+    constexpr uint32_t NO_VERTEX = UINT32_MAX;
+
+    /// @brief A candidate edge collapse moving source onto target. Seam collapses also move the source's partner onto the matching vertex across the seam
+    struct Collapse{
+        uint32_t source;
+        uint32_t target;
+        uint32_t partnerSource;
+        uint32_t partnerTarget;
+        float error;
+    };
+
+    glm::vec3 triangleNormal(glm::vec3 a, glm::vec3 b, glm::vec3 c){
+        return glm::cross(b - a, c - a);
+    }
+}
+
+std::vector<uint32_t> MeshOptimizer::simplify(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float* resultError){
+    std::vector<uint32_t> result = indices;
+    size_t vertexCount = vertices.size();
+    float maxError = 0.0f;
+
+    //Group vertices that share a position, eg. the corners on either side of a UV seam. Each group is a ring linked through wedges
+    //and identified by its first vertex in positionGroups
+    std::vector<uint32_t> wedges(vertexCount);
+    std::vector<uint32_t> positionGroups(vertexCount);
+    {
+        std::vector<uint32_t> order(vertexCount);
+        for(uint32_t vertex = 0; vertex < vertexCount; vertex++)
+            order[vertex] = vertex;
+        auto positionKey = [&vertices](uint32_t vertex){
+            const glm::vec3& position = vertices[vertex].position;
+            return std::make_tuple(position.x, position.y, position.z);
+        };
+        std::sort(order.begin(), order.end(), [&](uint32_t left, uint32_t right){ return positionKey(left) < positionKey(right); });
+        for(size_t begin = 0; begin < order.size();){
+            size_t end = begin + 1;
+            while(end < order.size() && positionKey(order[end]) == positionKey(order[begin]))
+                end++;
+            for(size_t idx = begin; idx < end; idx++){
+                wedges[order[idx]] = order[idx + 1 < end ? idx + 1 : begin];
+                positionGroups[order[idx]] = order[begin];
+            }
+            begin = end;
+        }
+    }
+
+    //Triangles around each vertex, rebuilt whenever the triangles change
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<uint32_t> adjacencyFill;
+    auto buildAdjacency = [&](){
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for(uint32_t index : result)
+            adjacencyOffsets[index + 1]++;
+        for(size_t vertex = 0; vertex < vertexCount; vertex++)
+            adjacencyOffsets[vertex + 1] += adjacencyOffsets[vertex];
+        adjacency.resize(result.size());
+        adjacencyFill.assign(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for(size_t idx = 0; idx < result.size(); idx++)
+            adjacency[adjacencyFill[result[idx]]++] = static_cast<uint32_t>(idx / 3);
+    };
+    //True if a triangle has the directed edge from -> to. Only the few triangles around from are searched
+    auto hasHalfEdge = [&](uint32_t from, uint32_t to){
+        for(uint32_t entry = adjacencyOffsets[from]; entry < adjacencyOffsets[from + 1]; entry++){
+            const uint32_t* triangle = &result[adjacency[entry] * 3];
+            for(int corner = 0; corner < 3; corner++){
+                if(triangle[corner] == from && triangle[(corner + 1) % 3] == to)
+                    return true;
+            }
+        }
+        return false;
+    };
+    auto isBorderEdge = [&](uint32_t a, uint32_t b){
+        return hasHalfEdge(a, b) != hasHalfEdge(b, a);
+    };
+
+    //Each vertex starts with the planes of its triangles, weighted by area, plus planes holding open borders in place
+    std::vector<Quadric> quadrics(vertexCount, Quadric{});
+    buildAdjacency();
+    for(size_t idx = 0; idx < result.size(); idx += 3){
+        glm::vec3 positions[3] = {vertices[result[idx]].position, vertices[result[idx + 1]].position, vertices[result[idx + 2]].position};
+        glm::vec3 normal = triangleNormal(positions[0], positions[1], positions[2]);
+        float doubleArea = glm::length(normal);
+        if(doubleArea == 0.0f)
+            continue;
+        normal = normal / doubleArea;
+
+        Quadric plane = makePlaneQuadric(normal, -glm::dot(normal, positions[0]), doubleArea * 0.5f);
+        for(int corner = 0; corner < 3; corner++)
+            addQuadric(quadrics[result[idx + corner]], plane);
+
+        for(int corner = 0; corner < 3; corner++){
+            uint32_t from = result[idx + corner];
+            uint32_t to = result[idx + (corner + 1) % 3];
+            if(hasHalfEdge(to, from))
+                continue;
+
+            //Plane through the border edge, perpendicular to the triangle
+            glm::vec3 edge = positions[(corner + 1) % 3] - positions[corner];
+            float edgeLength = glm::length(edge);
+            if(edgeLength == 0.0f)
+                continue;
+            glm::vec3 borderNormal = glm::normalize(glm::cross(edge, normal));
+            Quadric border = makePlaneQuadric(borderNormal, -glm::dot(borderNormal, positions[corner]), edgeLength * edgeLength * BORDER_WEIGHT);
+            addQuadric(quadrics[from], border);
+            addQuadric(quadrics[to], border);
+        }
+    }
+
+    std::vector<uint8_t> kinds(vertexCount);
+    //Open edges leaving and entering each vertex, with the vertex at the other end of the last one found
+    std::vector<uint8_t> openOutCounts(vertexCount);
+    std::vector<uint8_t> openInCounts(vertexCount);
+    std::vector<uint32_t> openOutTargets(vertexCount);
+    std::vector<uint32_t> openInSources(vertexCount);
+    //Other vertex at the same position as each seam vertex
+    std::vector<uint32_t> partners(vertexCount);
+    std::vector<Collapse> collapses;
+    std::vector<uint8_t> touched(vertexCount);
+    std::vector<uint32_t> remap(vertexCount);
+
+    //Each pass collapses a batch of the cheapest independent edges then rebuilds the topology
+    while(result.size() > targetIndexCount){
+        std::fill(openOutCounts.begin(), openOutCounts.end(), 0);
+        std::fill(openInCounts.begin(), openInCounts.end(), 0);
+        for(size_t idx = 0; idx < result.size(); idx += 3){
+            for(int corner = 0; corner < 3; corner++){
+                uint32_t from = result[idx + corner];
+                uint32_t to = result[idx + (corner + 1) % 3];
+                if(hasHalfEdge(to, from))
+                    continue;
+                openOutCounts[from] = static_cast<uint8_t>(std::min(openOutCounts[from] + 1, 2));
+                openOutTargets[from] = to;
+                openInCounts[to] = static_cast<uint8_t>(std::min(openInCounts[to] + 1, 2));
+                openInSources[to] = from;
+            }
+        }
+
+        //Classify each vertex by the other vertices still in use at its position
+        for(uint32_t vertex = 0; vertex < vertexCount; vertex++){
+            uint32_t liveWedges = 0;
+            uint32_t partner = NO_VERTEX;
+            for(uint32_t wedge = wedges[vertex]; wedge != vertex; wedge = wedges[wedge]){
+                if(adjacencyOffsets[wedge] != adjacencyOffsets[wedge + 1]){
+                    liveWedges++;
+                    partner = wedge;
+                }
+            }
+
+            if(liveWedges == 0){
+                kinds[vertex] = openOutCounts[vertex] != 0 || openInCounts[vertex] != 0 ? KIND_BORDER : KIND_MANIFOLD;
+                continue;
+            }
+
+            //A seam pairs two vertices whose single open edges run along the same positions in opposite directions, closing the surface between them
+            bool seam = liveWedges == 1
+                && openOutCounts[vertex] == 1 && openInCounts[vertex] == 1 && openOutCounts[partner] == 1 && openInCounts[partner] == 1
+                && positionGroups[openOutTargets[vertex]] == positionGroups[openInSources[partner]]
+                && positionGroups[openInSources[vertex]] == positionGroups[openOutTargets[partner]];
+            kinds[vertex] = seam ? KIND_SEAM : KIND_LOCKED;
+            partners[vertex] = partner;
+        }
+
+        //Cheapest allowed direction of every edge
+        collapses.clear();
+        auto canCollapse = [&](uint32_t source, uint32_t target){
+            if(kinds[source] == KIND_LOCKED)
+                return false;
+            if(kinds[source] == KIND_BORDER || kinds[source] == KIND_SEAM)
+                return isBorderEdge(source, target);
+            return true;
+        };
+        //Vertex the partner of a seam source moves onto, on the same side of the seam as the partner. NO_VERTEX for other sources
+        auto getPartnerTarget = [&](uint32_t source, uint32_t target){
+            if(kinds[source] != KIND_SEAM)
+                return NO_VERTEX;
+            uint32_t partner = partners[source];
+            return target == openOutTargets[source] ? openInSources[partner] : openOutTargets[partner];
+        };
+        //Error of moving source onto target, and the partner along with it for seams
+        auto getCollapseError = [&](uint32_t source, uint32_t target, uint32_t partnerTarget){
+            Quadric combined = quadrics[source];
+            addQuadric(combined, quadrics[target]);
+            float error = evaluateQuadric(combined, vertices[target].position);
+            if(partnerTarget != NO_VERTEX && partnerTarget != target){
+                Quadric partnerCombined = quadrics[partners[source]];
+                addQuadric(partnerCombined, quadrics[partnerTarget]);
+                error = std::max(error, evaluateQuadric(partnerCombined, vertices[partnerTarget].position));
+            }
+            return error;
+        };
+        for(size_t idx = 0; idx < result.size(); idx += 3){
+            for(int corner = 0; corner < 3; corner++){
+                uint32_t a = result[idx + corner];
+                uint32_t b = result[idx + (corner + 1) % 3];
+                //Interior edges are seen from both triangles; only take them once
+                if(a > b && hasHalfEdge(b, a))
+                    continue;
+
+                Collapse best{0, 0, NO_VERTEX, NO_VERTEX, -1.0f};
+                if(canCollapse(a, b)){
+                    uint32_t partnerTarget = getPartnerTarget(a, b);
+                    best = {a, b, partnerTarget != NO_VERTEX ? partners[a] : NO_VERTEX, partnerTarget, getCollapseError(a, b, partnerTarget)};
+                }
+                if(canCollapse(b, a)){
+                    uint32_t partnerTarget = getPartnerTarget(b, a);
+                    float error = getCollapseError(b, a, partnerTarget);
+                    if(best.error < 0.0f || error < best.error)
+                        best = {b, a, partnerTarget != NO_VERTEX ? partners[b] : NO_VERTEX, partnerTarget, error};
+                }
+                if(best.error >= 0.0f)
+                    collapses.push_back(best);
+            }
+        }
+        if(collapses.empty())
+            break;
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& left, const Collapse& right){ return left.error < right.error; });
+
+        //A collapse removes up to two triangles. Leave room for later passes to pick from the updated costs
+        size_t trianglesToRemove = (result.size() - targetIndexCount) / 3;
+        size_t collapseLimit = std::max<size_t>(1, trianglesToRemove / 2);
+        size_t collapseCount = 0;
+
+        std::fill(touched.begin(), touched.end(), 0);
+        for(uint32_t vertex = 0; vertex < vertexCount; vertex++)
+            remap[vertex] = vertex;
+
+        auto wouldFlip = [&](uint32_t source, uint32_t target){
+            glm::vec3 targetPosition = vertices[target].position;
+            for(uint32_t entry = adjacencyOffsets[source]; entry < adjacencyOffsets[source + 1]; entry++){
+                const uint32_t* triangle = &result[adjacency[entry] * 3];
+                if(triangle[0] == target || triangle[1] == target || triangle[2] == target)
+                    continue;
+
+                glm::vec3 before[3];
+                glm::vec3 after[3];
+                for(int corner = 0; corner < 3; corner++){
+                    before[corner] = vertices[triangle[corner]].position;
+                    after[corner] = triangle[corner] == source ? targetPosition : before[corner];
+                }
+                glm::vec3 normalBefore = triangleNormal(before[0], before[1], before[2]);
+                glm::vec3 normalAfter = triangleNormal(after[0], after[1], after[2]);
+                if(glm::dot(normalBefore, normalAfter) <= FLIP_THRESHOLD * glm::length(normalBefore) * glm::length(normalAfter))
+                    return true;
+            }
+            return false;
+        };
+        auto freezeNeighbourhood = [&](uint32_t source, uint32_t target){
+            for(uint32_t entry = adjacencyOffsets[source]; entry < adjacencyOffsets[source + 1]; entry++){
+                const uint32_t* triangle = &result[adjacency[entry] * 3];
+                touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = 1;
+            }
+            touched[target] = 1;
+        };
+
+        for(const Collapse& collapse : collapses){
+            if(collapseCount >= collapseLimit)
+                break;
+            bool pairedCollapse = collapse.partnerSource != NO_VERTEX;
+            if(touched[collapse.source] || touched[collapse.target])
+                continue;
+            if(pairedCollapse && (touched[collapse.partnerSource] || touched[collapse.partnerTarget]))
+                continue;
+
+            //Reject collapses that would flip or crush a surviving triangle
+            if(wouldFlip(collapse.source, collapse.target) || (pairedCollapse && wouldFlip(collapse.partnerSource, collapse.partnerTarget)))
+                continue;
+
+            //Freeze the neighbourhood so the flip test above stays valid for the rest of the pass
+            freezeNeighbourhood(collapse.source, collapse.target);
+            remap[collapse.source] = collapse.target;
+            addQuadric(quadrics[collapse.target], quadrics[collapse.source]);
+
+            //Move the other side of the seam along with the source so the seam stays closed
+            if(pairedCollapse){
+                freezeNeighbourhood(collapse.partnerSource, collapse.partnerTarget);
+                remap[collapse.partnerSource] = collapse.partnerTarget;
+                addQuadric(quadrics[collapse.partnerTarget], quadrics[collapse.partnerSource]);
+            }
+            maxError = std::max(maxError, collapse.error);
+            collapseCount++;
+        }
+        if(collapseCount == 0)
+            break;
+
+        //Apply the collapses and drop the triangles that became degenerate
+        size_t writeIdx = 0;
+        for(size_t idx = 0; idx < result.size(); idx += 3){
+            uint32_t a = remap[result[idx]];
+            uint32_t b = remap[result[idx + 1]];
+            uint32_t c = remap[result[idx + 2]];
+            if(a == b || b == c || a == c)
+                continue;
+            result[writeIdx++] = a;
+            result[writeIdx++] = b;
+            result[writeIdx++] = c;
+        }
+        result.resize(writeIdx);
+        buildAdjacency();
+    }
+
+    if(resultError != nullptr)
+        *resultError = std::sqrt(maxError);
+    return result;
+}
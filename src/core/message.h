@@ -1,51 +1,303 @@
 #pragma once
 
-#include <queue>
-#include <mutex>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <type_traits>
 
 enum MessageType{
-    MSG_INVALID
+    MSG_INVALID,
+    //A worker finished decoding a mesh. Payload: AssetDecodedPayload
+    MSG_MESH_DECODED,
+    //A worker finished decoding an image. Payload: AssetDecodedPayload
+    MSG_IMAGE_DECODED,
+    //A worker failed to decode a mesh. Payload: AssetDecodedPayload with no decoded data
+    MSG_MESH_FAILED,
+    //A worker failed to decode an image. Payload: AssetDecodedPayload with no decoded data
+    MSG_IMAGE_FAILED
+};
+
+/// @brief Payload posted by asynchronous imports. The decoded asset is moved into the target handle on the main thread
+struct AssetDecodedPayload{
+    //Handle returned to the caller of the import
+    void* target;
+    //Temporary asset filled by the worker. Nullptr on failure
+    void* decoded;
+    //Upload to the GPU once the data is moved into the target
+    bool pushToGPU;
+    //Hash of the source file's contents. 0 if it couldn't be read
+    uint64_t contentHash;
 };
 
 class Message{
 public:
+    //Size of the inline payload. Larger data should be posted as a pointer
+    static constexpr size_t PAYLOAD_SIZE = 48;
+
     //Type of message
     MessageType type;
-    //Pointer to the data held by the message. The message system will not interact with this in any way
-    void* data;
 
-    Message(MessageType a_type, void* a_data = nullptr)
-        :type(a_type), data(a_data){}
+    Message(MessageType a_type = MessageType::MSG_INVALID)
+        :type(a_type), payloadSize(0){}
+
+    /// @brief Creates a message with a copy of the payload stored inline
+    /// @param a_type The type of message
+    /// @param payload The data carried by the message. Must be trivially copyable and fit within PAYLOAD_SIZE
+    /// @return
+    template<typename T>
+    static Message create(MessageType a_type, const T& payload){
+        static_assert(std::is_trivially_copyable<T>::value, "Message payloads must be trivially copyable");
+        static_assert(sizeof(T) <= PAYLOAD_SIZE, "Message payload is larger than Message::PAYLOAD_SIZE");
+        static_assert(alignof(T) <= alignof(std::max_align_t), "Message payload is over-aligned");
+
+        Message message(a_type);
+        std::memcpy(message.payload, &payload, sizeof(T));
+        message.payloadSize = static_cast<uint8_t>(sizeof(T));
+        return message;
+    }
+
+    /// @brief Returns a copy of the payload
+    /// @return
+    template<typename T>
+    T get() const{
+        static_assert(std::is_trivially_copyable<T>::value, "Message payloads must be trivially copyable");
+        static_assert(sizeof(T) <= PAYLOAD_SIZE, "Message payload is larger than Message::PAYLOAD_SIZE");
+
+        T output;
+        std::memcpy(&output, payload, sizeof(T));
+        return output;
+    }
+
+    /// @brief Returns the size in bytes of the payload the message was created with
+    /// @return
+    size_t getPayloadSize() const{
+        return payloadSize;
+    }
+
+private:
+    //Inline payload storage so posting a message never allocates
+    alignas(std::max_align_t) unsigned char payload[PAYLOAD_SIZE];
+    uint8_t payloadSize;
+};
+
+/// @brief Counters describing how full a message queue has run
+struct MessageQueueStats{
+    //Messages accepted by the queue
+    uint64_t pushed;
+    //Messages removed by the consumer
+    uint64_t popped;
+    //Push attempts that found the queue full
+    uint64_t rejected;
+    //Largest number of messages waiting at once
+    uint64_t peakDepth;
 };
 
+/// @brief Bounded lock-free multi-producer, single-consumer ring of messages.
+///     Each cell carries a sequence number that tells producers and the consumer whose turn it is, so pushing is a single compare-exchange on the write position
+///     Any thread can push; only the owning thread (the main thread for the engine's queue) may pop or drain
 class MessageQueue{
 public:
-    /// @brief Adds a message to the queue
-    /// @param a_message 
-    static void push(Message a_message){
-        //Lock the queue with the mutex for thread safety
-        std::lock_guard<std::mutex> lock(mutex);
-
-        //Push the message into the queue
-        queue.push(std::move(a_message));
-    }
-
-    static Message pop(){
-        //Lock the queue with the mutex for thread safety
-        std::lock_guard<std::mutex> lock(mutex);
-        
-        //Ensure the thread isn't empty
-        if(queue.empty())
-            return Message(MessageType::MSG_INVALID);
-        
-        //Consume the front message from the queue
-        Message msg = std::move(queue.front());
-        queue.pop();
-        //Return the message to the caller
-        return msg;
+    /// @brief Creates a queue
+    /// @param capacity Number of messages the queue can hold. Rounded up to a power of two
+    MessageQueue(size_t capacity = 4096){
+        size_t roundedCapacity = 2;
+        while(roundedCapacity < capacity)
+            roundedCapacity <<= 1;
+
+        mask = roundedCapacity - 1;
+        cells.reset(new Cell[roundedCapacity]);
+        for(size_t idx = 0; idx < roundedCapacity; idx++)
+            cells[idx].sequence.store(idx, std::memory_order_relaxed);
+
+        enqueuePosition.store(0, std::memory_order_relaxed);
+        dequeuePosition.store(0, std::memory_order_relaxed);
+        resetStats();
+    }
+
+    MessageQueue(const MessageQueue&) = delete;
+    MessageQueue& operator=(const MessageQueue&) = delete;
+
+    /// @brief Returns the queue worker threads post to
+    /// @return
+    static MessageQueue* getActive(){
+        return activeQueue();
+    }
+
+    /// @brief Sets the queue worker threads post to
+    /// @param queue The queue to make active
+    static void setActive(MessageQueue* queue){
+        activeQueue() = queue;
+    }
+
+    /// @brief Attempts to add a message to the queue. Safe to call from any thread
+    /// @param message The message to add
+    /// @return False if the queue is full
+    bool tryPush(const Message& message){
+        size_t position = enqueuePosition.load(std::memory_order_relaxed);
+        Cell* cell;
+
+        while(true){
+            cell = &cells[position & mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+            //Cell is free for this position, try to claim it
+            if(difference == 0){
+                if(enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    break;
+            }
+            //Cell still holds a message from the previous lap; the queue is full
+            else if(difference < 0){
+                rejected.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            //Another producer claimed the position, reload and retry
+            else
+                position = enqueuePosition.load(std::memory_order_relaxed);
+        }
+
+        cell->message = message;
+        //Publish the message to the consumer
+        cell->sequence.store(position + 1, std::memory_order_release);
+
+        pushed.fetch_add(1, std::memory_order_relaxed);
+        //The consumer may already have popped this message and later ones, so take the clamped depth rather than subtracting from our position
+        updatePeakDepth(getDepth());
+        return true;
+    }
+
+    /// @brief Registers the calling thread as the queue's consumer, the only thread that pops or drains
+    void setConsumerThread(){
+        consumerThread.store(std::this_thread::get_id(), std::memory_order_relaxed);
+    }
+
+    /// @brief Adds a message to the queue, yielding while the queue is full. Safe to call from any thread
+    ///     The consumer can't wait on itself to make room, so a full queue fails the push on the consumer thread instead
+    /// @param message The message to add
+    /// @return False if the queue was full and the caller is the consumer
+    bool push(const Message& message){
+        while(!tryPush(message)){
+            if(std::this_thread::get_id() == consumerThread.load(std::memory_order_relaxed))
+                return false;
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    /// @brief Creates a message with an inline payload and adds it to the queue, yielding while the queue is full. Safe to call from any thread
+    /// @param type The type of message
+    /// @param payload The data carried by the message
+    /// @return False if the queue was full and the caller is the consumer
+    template<typename T>
+    bool post(MessageType type, const T& payload){
+        return push(Message::create(type, payload));
+    }
+
+    /// @brief Removes the oldest message from the queue. Consumer thread only
+    /// @param output Reference to the message to populate
+    /// @return False if the queue is empty
+    bool tryPop(Message& output){
+        size_t position = dequeuePosition.load(std::memory_order_relaxed);
+        Cell& cell = cells[position & mask];
+
+        //Message for this position hasn't been published yet
+        if(cell.sequence.load(std::memory_order_acquire) != position + 1)
+            return false;
+
+        output = cell.message;
+        //Release the cell to producers on the next lap
+        cell.sequence.store(position + mask + 1, std::memory_order_release);
+        dequeuePosition.store(position + 1, std::memory_order_relaxed);
+
+        popped.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /// @brief Removes messages in order and passes them to a handler. Consumer thread only
+    ///     Messages posted while draining are left for the next drain once maxCount is reached
+    /// @param handler Callable taking (const Message&)
+    /// @param maxCount Maximum number of messages to remove
+    /// @return Returns the number of messages handled
+    template<typename Func>
+    size_t drain(Func handler, size_t maxCount = SIZE_MAX){
+        size_t count = 0;
+        Message message;
+        while(count < maxCount && tryPop(message)){
+            handler(message);
+            count++;
+        }
+        return count;
+    }
+
+    /// @brief Returns the number of messages the queue can hold
+    /// @return
+    size_t getCapacity() const{
+        return mask + 1;
+    }
+
+    /// @brief Returns an approximate count of waiting messages. Exact when called from the consumer with no producers running
+    /// @return
+    size_t getDepth() const{
+        size_t enqueue = enqueuePosition.load(std::memory_order_relaxed);
+        size_t dequeue = dequeuePosition.load(std::memory_order_relaxed);
+        return enqueue > dequeue ? enqueue - dequeue : 0;
+    }
+
+    /// @brief Returns the back-pressure counters of the queue
+    /// @return
+    MessageQueueStats getStats() const{
+        return {
+            pushed.load(std::memory_order_relaxed),
+            popped.load(std::memory_order_relaxed),
+            rejected.load(std::memory_order_relaxed),
+            peakDepth.load(std::memory_order_relaxed)
+        };
+    }
+
+    /// @brief Clears the back-pressure counters
+    void resetStats(){
+        pushed.store(0, std::memory_order_relaxed);
+        popped.store(0, std::memory_order_relaxed);
+        rejected.store(0, std::memory_order_relaxed);
+        peakDepth.store(0, std::memory_order_relaxed);
     }
 
 private:
-    static std::queue<Message> queue;
-    static std::mutex mutex;
-};
\ No newline at end of file
+    /// @brief Slot in the ring. The sequence equals the position when the cell is free and position + 1 once it holds a message
+    struct Cell{
+        std::atomic<size_t> sequence;
+        Message message;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+
+    //Write and read positions are kept on separate cache lines so producers and the consumer don't false-share
+    alignas(64) std::atomic<size_t> enqueuePosition;
+    alignas(64) std::atomic<size_t> dequeuePosition;
+
+    alignas(64) std::atomic<uint64_t> pushed;
+    std::atomic<uint64_t> popped;
+    std::atomic<uint64_t> rejected;
+    std::atomic<uint64_t> peakDepth;
+
+    //Thread registered by setConsumerThread. Default constructed, matching no thread, until then
+    std::atomic<std::thread::id> consumerThread;
+
+    /// @brief Raises the recorded peak depth if the given depth is higher
+    /// @param depth The depth observed by a producer
+    void updatePeakDepth(uint64_t depth){
+        uint64_t peak = peakDepth.load(std::memory_order_relaxed);
+        while(depth > peak && !peakDepth.compare_exchange_weak(peak, depth, std::memory_order_relaxed)){}
+    }
+
+    /// @brief Storage for the active queue. Function local so the header-only queue doesn't need a translation unit
+    /// @return
+    static MessageQueue*& activeQueue(){
+        static MessageQueue* queue = nullptr;
+        return queue;
+    }
+};
@@ -1,28 +1,32 @@
+#include <stdexcept>
 #include "object_p.h"
 
-Object::Object() : pImpl(std::make_unique<ObjectImpl>()) {
-    transform = new Transform();
+Object::Object() : pImpl(std::make_unique<ObjectImpl>(this)) {
+    //The transform handle lives alongside the rest of the object's internal data
+    transform = &pImpl->transform;
+    pImpl->addComponent(transform);
 }
 
 Object::~Object(){}
 
-Object::ObjectImpl::ObjectImpl(){
+Object::ObjectImpl::ObjectImpl(Object* owner) : lodLevel(0), isStatic(false){
+    registry = ComponentRegistry::getActive();
+    if(registry == nullptr)
+        throw std::runtime_error("Failed to create object. No active component registry; the engine must be created first");
+
+    entity = registry->createEntity(owner);
 }
 
 Object::ObjectImpl::~ObjectImpl(){
     cleanup();
+    registry->destroyEntity(entity);
 }
 
 bool Object::addComponent(Component* _component){
     return pImpl->addComponent(_component);
 }
 bool Object::ObjectImpl::addComponent(Component* _component){
-    for(auto component : components)
-        if(component->type == _component->type)
-            return false;
-
-    components.push_back(_component);
-    return true;
+    return registry->addComponent(entity, _component);
 }
 
 Component* Object::getComponent(const ComponentType componentType){
@@ -32,19 +36,37 @@ Component* Object::getComponent(const ComponentType componentType){
     return pImpl->getComponent(componentType);
 }
 Component* Object::ObjectImpl::getComponent(const ComponentType componentType){
-    for(auto component : components)
-        if(component->type == componentType)
-            return component;
-        
-    return nullptr;
+    return registry->getComponent(entity, componentType);
+}
+
+void Object::setStatic(bool isStatic){
+    pImpl->isStatic = isStatic;
+}
+
+bool Object::getIsStatic() const{
+    return pImpl->isStatic;
+}
+
+uint32_t Object::getEntity() const{
+    return pImpl->getEntity();
+}
+
+uint32_t Object::getLodLevel() const{
+    return pImpl->lodLevel;
+}
+
+void Object::setLodLevel(uint32_t level){
+    pImpl->lodLevel = level;
 }
 
 void Object::cleanup(){
-    delete transform;
     pImpl->cleanup();
 }
 void Object::ObjectImpl::cleanup(){
-    components.clear();
+    //Remove every component except the transform, which is owned by the object
+    for(int type = 0; type < ComponentType::COMP_COUNT; type++)
+        if(type != ComponentType::COMP_TRANSFORM)
+            registry->removeComponent(entity, static_cast<ComponentType>(type));
 }
 
 void Object::update(float deltaTime){
@@ -4,14 +4,31 @@
 #include <vector>
 #include "object.h"
 #include "transform.h"
+#include "componentRegistry.h"
 
 class Object::ObjectImpl {
 public:
-    ObjectImpl();
+    ObjectImpl(Object*);
     ~ObjectImpl();
     bool addComponent(Component*);
     Component* getComponent(const ComponentType);
     virtual void cleanup();
+
+    //Handle to the object's entry in the transform store
+    Transform transform;
+    //Detail level last selected for the object's mesh
+    uint32_t lodLevel;
+    //True if the object never moves and can be merged into a static batch
+    bool isStatic;
+
+    /// @brief Returns the object's entity within the registry
+    /// @return
+    ComponentRegistry::Entity getEntity() const{
+        return entity;
+    }
 private:
-    std::vector<Component*> components;
+    //Registry that stores the object's components
+    ComponentRegistry* registry;
+    //The object's entity within the registry
+    ComponentRegistry::Entity entity;
 };
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include <chrono>
+#include <exception>
+#include "renderThread.h"
+#include "renderer.h"
+
+RenderThread::RenderThread() : renderer(nullptr), nextFrameIndex(0), renderedFrameCount(0), running(false), failed(false){
+}
+
+RenderThread::~RenderThread(){
+    stop();
+}
+
+void RenderThread::start(Renderer* a_renderer){
+    if(running.load())
+        return;
+
+    renderer = a_renderer;
+    failed.store(false);
+    running.store(true);
+    thread = std::thread(&RenderThread::threadLoop, this);
+}
+
+void RenderThread::stop(){
+    if(!running.exchange(false))
+        return;
+
+    wakeCondition.notify_one();
+    if(thread.joinable())
+        thread.join();
+}
+
+FrameSnapshot& RenderThread::beginSnapshot(){
+    FrameSnapshot& snapshot = snapshots.getWriteSlot();
+    snapshot.clear();
+    snapshot.frameIndex = nextFrameIndex++;
+    return snapshot;
+}
+
+void RenderThread::submitSnapshot(){
+    snapshots.publish();
+
+    //Notifying without the lock keeps the main thread lock free. A missed wakeup is covered by the wait timeout
+    wakeCondition.notify_one();
+}
+
+uint64_t RenderThread::getNextFrameIndex() const{
+    return nextFrameIndex;
+}
+
+uint64_t RenderThread::getRenderedFrameCount() const{
+    return renderedFrameCount.load(std::memory_order_acquire);
+}
+
+bool RenderThread::isRunning() const{
+    return running.load(std::memory_order_acquire);
+}
+
+bool RenderThread::hasFailed() const{
+    return failed.load(std::memory_order_acquire);
+}
+
+std::string RenderThread::getFailureMessage(){
+    std::lock_guard<std::mutex> lock(failureMutex);
+    return failureMessage;
+}
+
+void RenderThread::threadLoop(){
+    while(running.load(std::memory_order_acquire)){
+        //Wait for the main thread to publish a new snapshot
+        if(!snapshots.acquire()){
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wakeCondition.wait_for(lock, std::chrono::milliseconds(1));
+            continue;
+        }
+
+        try{
+            const FrameSnapshot& snapshot = snapshots.getReadSlot();
+            renderer->render(snapshot);
+            renderedFrameCount.store(snapshot.frameIndex + 1, std::memory_order_release);
+        } catch(const std::exception& e){
+            {
+                std::lock_guard<std::mutex> lock(failureMutex);
+                failureMessage = e.what();
+            }
+            failed.store(true, std::memory_order_release);
+            running.store(false);
+            return;
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "frameSnapshot.h"
+
+class Renderer;
+
+/// @brief Runs the renderer on its own thread. The main thread fills a snapshot each frame and publishes it without blocking
+///     while the render thread records and submits the latest published snapshot. Frames the render thread can't keep up with are dropped
+class RenderThread{
+public:
+    RenderThread();
+    ~RenderThread();
+
+    /// @brief Starts the render thread
+    /// @param renderer The initialized renderer that will be driven by the thread
+    void start(Renderer*);
+
+    /// @brief Finishes the frame in progress and stops the render thread
+    void stop();
+
+    /// @brief Returns an empty snapshot for the main thread to fill. Main thread only
+    /// @return
+    FrameSnapshot& beginSnapshot();
+
+    /// @brief Publishes the snapshot returned by beginSnapshot to the render thread. Main thread only
+    void submitSnapshot();
+
+    /// @brief Returns the id the next snapshot will be given. Main thread only
+    /// @return
+    uint64_t getNextFrameIndex() const;
+
+    /// @brief Returns one past the id of the last snapshot the render thread finished rendering. Every snapshot before it is no longer being read
+    /// @return
+    uint64_t getRenderedFrameCount() const;
+
+    /// @brief Returns true while the render thread is running
+    /// @return
+    bool isRunning() const;
+
+    /// @brief Returns true if the renderer threw on the render thread. The thread stops after a failure
+    /// @return
+    bool hasFailed() const;
+
+    /// @brief Returns the message of the exception that stopped the render thread
+    /// @return
+    std::string getFailureMessage();
+
+private:
+    //Renderer driven by the thread
+    Renderer* renderer;
+    std::thread thread;
+
+    //Snapshots shared between the main thread and the render thread
+    TripleBuffer<FrameSnapshot> snapshots;
+    //Id given to the next snapshot
+    uint64_t nextFrameIndex;
+
+    //One past the id of the last rendered snapshot
+    std::atomic<uint64_t> renderedFrameCount;
+
+    std::atomic<bool> running;
+    std::atomic<bool> failed;
+    std::string failureMessage;
+    std::mutex failureMutex;
+
+    //Used by the render thread to sleep while no new snapshot is available
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+
+    /// @brief Main loop of the render thread
+    void threadLoop();
+};
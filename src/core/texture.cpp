@@ -3,7 +3,7 @@
 #include "rendererData.h"
 
 Texture::Texture()
-    : pRendererData(std::make_unique<RendererData>()){
+    : pRendererData(std::make_unique<RendererData>()), state(AssetState::ASSET_LOADED){
     width = 0;
     height = 0;
     channels = 0;
@@ -13,11 +13,19 @@ Texture::Texture()
 }
 
 Texture::Texture(int _width, int _height, int _channels = 4)
-    : pRendererData(std::make_unique<RendererData>()){
+    : pRendererData(std::make_unique<RendererData>()), state(AssetState::ASSET_LOADED){
     width = _width;
     height = _height;
     channels = _channels;
 
     pRendererData->rawData = nullptr;
     pRendererData->rendererData = nullptr;
+}
+
+AssetState Texture::getState() const{
+    return state.load(std::memory_order_acquire);
+}
+
+void Texture::setState(AssetState newState){
+    state.store(newState, std::memory_order_release);
 }
\ No newline at end of file
@@ -1,46 +1,94 @@
 #define GLM_ENABLE_EXPERIMENTAL
+#include <stdexcept>
 #include "glm/gtx/quaternion.hpp"
 #include "transform.h"
+#include "transformStore.h"
 
 Transform::Transform(){
     type = ComponentType::COMP_TRANSFORM;
 
-    position = glm::vec3(0.0f);
-    rotation = glm::vec3(0.0f);
-    scale = glm::vec3(1.0f);
+    //Dirty state is tracked by the store
+    isDirty = false;
 
-    quatRot = glm::quat(glm::vec3(0,0,0));
+    store = TransformStore::getActive();
+    if(store == nullptr)
+        throw std::runtime_error("Failed to create transform. No active transform store; the engine must be created first");
 
-    //Set initial flag to true to ensure it gets passed in initially
-    isDirty = true;
+    //Entries are allocated as identity transforms and flagged dirty so they get built on the next update
+    id = store->allocate(this);
+}
+
+Transform::~Transform(){
+    //Children become roots and the entry is returned to the store
+    store->release(id);
 }
 
     void Transform::setPosition(glm::vec3 newPosition){
-        position = newPosition;
-        //position.y *= -1;
-        isDirty = true;
+        store->setPosition(id, newPosition);
+    }
+
+    glm::vec3 Transform::getPosition() const{
+        return store->getPosition(id);
     }
 
     void Transform::setRotation(glm::vec3 newRotation){
         //Deg to Rad
-        rotation = glm::radians(newRotation);
-        quatRot = glm::quat(rotation);
-        isDirty = true;
+        store->setRotation(id, glm::quat(glm::radians(newRotation)));
+    }
+
+    glm::vec3 Transform::getRotation() const{
+        //Rad to Deg
+        return glm::degrees(glm::eulerAngles(store->getRotation(id)));
+    }
+
+    void Transform::setQuaternion(glm::quat newRotation){
+        store->setRotation(id, newRotation);
+    }
+
+    glm::quat Transform::getQuaternion() const{
+        return store->getRotation(id);
     }
 
     void Transform::setScale(glm::vec3 newScale){
-        scale = newScale;
-        isDirty = true;
+        store->setScale(id, newScale);
+    }
+
+    glm::vec3 Transform::getScale() const{
+        return store->getScale(id);
     }
 
     glm::mat4 Transform::getRotationMatrix() const{
-        return glm::toMat4(quatRot);
+        return glm::toMat4(store->getRotation(id));
+    }
+
+    glm::mat4 Transform::getLocalMatrix() const{
+        return store->getLocalMatrix(id).toMat4();
     }
 
     glm::mat4 Transform::getTransformMatrix() const{
-        glm::mat4 transformMatrix = glm::translate(glm::mat4(1.0f), position);
-        transformMatrix *= getRotationMatrix();
-        transformMatrix = glm::scale(transformMatrix, scale);
+        return store->getWorldMatrix(id).toMat4();
+    }
+
+    bool Transform::setParent(Transform* newParent){
+        return store->setParent(id, newParent != nullptr ? newParent->id : TransformStore::INVALID_ID);
+    }
+
+    Transform* Transform::getParent() const{
+        TransformStore::Id parent = store->getParent(id);
+        return parent != TransformStore::INVALID_ID ? store->getOwner(parent) : nullptr;
+    }
+
+    std::vector<Transform*> Transform::getChildren() const{
+        std::vector<Transform*> output;
+        for(auto child : store->getChildren(id))
+            output.push_back(store->getOwner(child));
+        return output;
+    }
 
-        return transformMatrix; 
-    }
\ No newline at end of file
+    bool Transform::getIsDirty() const{
+        return store->isDirty(id);
+    }
+
+    uint32_t Transform::getId() const{
+        return id;
+    }
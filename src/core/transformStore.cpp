@@ -0,0 +1,461 @@
+#include <stdexcept>
+#include "transformStore.h"
+#include "jobSystem.h"
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64)
+    #include <xmmintrin.h>
+    #define TRANSFORM_STORE_SSE
+#endif
+
+TransformStore* TransformStore::activeStore = nullptr;
+
+TransformStore::TransformStore()
+    : parentedCount(0){
+}
+
+TransformStore::~TransformStore(){
+    if(activeStore == this)
+        activeStore = nullptr;
+}
+
+TransformStore* TransformStore::getActive(){
+    return activeStore;
+}
+
+void TransformStore::setActive(TransformStore* store){
+    activeStore = store;
+}
+
+TransformStore::Id TransformStore::allocate(Transform* owner){
+    //Reuse a released id if one is available
+    Id id;
+    if(!freeIds.empty()){
+        id = freeIds.back();
+        freeIds.pop_back();
+    }
+    else{
+        id = static_cast<Id>(idToDense.size());
+        idToDense.push_back(INVALID_ID);
+    }
+
+    //New entries are appended to the end of the dense arrays
+    uint32_t dense = static_cast<uint32_t>(denseToId.size());
+    idToDense[id] = dense;
+    denseToId.push_back(id);
+    owners.push_back(owner);
+
+    //Identity transform
+    positionX.push_back(0.0f);
+    positionY.push_back(0.0f);
+    positionZ.push_back(0.0f);
+    rotationX.push_back(0.0f);
+    rotationY.push_back(0.0f);
+    rotationZ.push_back(0.0f);
+    rotationW.push_back(1.0f);
+    scaleX.push_back(1.0f);
+    scaleY.push_back(1.0f);
+    scaleZ.push_back(1.0f);
+    localMatrices.push_back(Matrix3x4{});
+    worldMatrices.push_back(Matrix3x4{});
+
+    parents.push_back(INVALID_ID);
+    firstChildren.push_back(INVALID_ID);
+    nextSiblings.push_back(INVALID_ID);
+
+    //Set initial flag to ensure the matrices get built on the next update
+    dirtyFlags.push_back(0);
+    markDirty(dense);
+    return id;
+}
+
+void TransformStore::release(Id id){
+    uint32_t dense = idToDense[id];
+
+    detachFromParent(id);
+
+    //Children become roots
+    Id child = firstChildren[dense];
+    while(child != INVALID_ID){
+        uint32_t childDense = idToDense[child];
+        Id next = nextSiblings[childDense];
+        parents[childDense] = INVALID_ID;
+        nextSiblings[childDense] = INVALID_ID;
+        parentedCount--;
+        markDirty(childDense);
+        child = next;
+    }
+    firstChildren[dense] = INVALID_ID;
+
+    //Move the last entry into the released slot to keep the arrays packed
+    uint32_t last = static_cast<uint32_t>(denseToId.size() - 1);
+    if(dense != last){
+        positionX[dense] = positionX[last];
+        positionY[dense] = positionY[last];
+        positionZ[dense] = positionZ[last];
+        rotationX[dense] = rotationX[last];
+        rotationY[dense] = rotationY[last];
+        rotationZ[dense] = rotationZ[last];
+        rotationW[dense] = rotationW[last];
+        scaleX[dense] = scaleX[last];
+        scaleY[dense] = scaleY[last];
+        scaleZ[dense] = scaleZ[last];
+        localMatrices[dense] = localMatrices[last];
+        worldMatrices[dense] = worldMatrices[last];
+        parents[dense] = parents[last];
+        firstChildren[dense] = firstChildren[last];
+        nextSiblings[dense] = nextSiblings[last];
+        dirtyFlags[dense] = dirtyFlags[last];
+        owners[dense] = owners[last];
+        denseToId[dense] = denseToId[last];
+        idToDense[denseToId[dense]] = dense;
+    }
+
+    positionX.pop_back();
+    positionY.pop_back();
+    positionZ.pop_back();
+    rotationX.pop_back();
+    rotationY.pop_back();
+    rotationZ.pop_back();
+    rotationW.pop_back();
+    scaleX.pop_back();
+    scaleY.pop_back();
+    scaleZ.pop_back();
+    localMatrices.pop_back();
+    worldMatrices.pop_back();
+    parents.pop_back();
+    firstChildren.pop_back();
+    nextSiblings.pop_back();
+    dirtyFlags.pop_back();
+    owners.pop_back();
+    denseToId.pop_back();
+
+    idToDense[id] = INVALID_ID;
+    freeIds.push_back(id);
+}
+
+glm::vec3 TransformStore::getPosition(Id id) const{
+    uint32_t dense = idToDense[id];
+    return glm::vec3(positionX[dense], positionY[dense], positionZ[dense]);
+}
+
+void TransformStore::setPosition(Id id, glm::vec3 position){
+    uint32_t dense = idToDense[id];
+    positionX[dense] = position.x;
+    positionY[dense] = position.y;
+    positionZ[dense] = position.z;
+    markDirty(dense);
+}
+
+glm::quat TransformStore::getRotation(Id id) const{
+    uint32_t dense = idToDense[id];
+    return glm::quat(rotationW[dense], rotationX[dense], rotationY[dense], rotationZ[dense]);
+}
+
+void TransformStore::setRotation(Id id, glm::quat rotation){
+    uint32_t dense = idToDense[id];
+    rotationX[dense] = rotation.x;
+    rotationY[dense] = rotation.y;
+    rotationZ[dense] = rotation.z;
+    rotationW[dense] = rotation.w;
+    markDirty(dense);
+}
+
+glm::vec3 TransformStore::getScale(Id id) const{
+    uint32_t dense = idToDense[id];
+    return glm::vec3(scaleX[dense], scaleY[dense], scaleZ[dense]);
+}
+
+void TransformStore::setScale(Id id, glm::vec3 scale){
+    uint32_t dense = idToDense[id];
+    scaleX[dense] = scale.x;
+    scaleY[dense] = scale.y;
+    scaleZ[dense] = scale.z;
+    markDirty(dense);
+}
+
+bool TransformStore::isDirty(Id id) const{
+    return dirtyFlags[idToDense[id]] != 0;
+}
+
+bool TransformStore::setParent(Id id, Id parentId){
+    uint32_t dense = idToDense[id];
+    if(parents[dense] == parentId)
+        return true;
+
+    //Walk up from the new parent to ensure the entry isn't one of its ancestors
+    for(Id ancestor = parentId; ancestor != INVALID_ID; ancestor = parents[idToDense[ancestor]])
+        if(ancestor == id)
+            return false;
+
+    detachFromParent(id);
+
+    if(parentId != INVALID_ID){
+        //Push the entry onto the front of the parent's child list
+        uint32_t parentDense = idToDense[parentId];
+        parents[dense] = parentId;
+        nextSiblings[dense] = firstChildren[parentDense];
+        firstChildren[parentDense] = id;
+        parentedCount++;
+    }
+
+    //The world matrix is now relative to a different parent
+    markDirty(dense);
+    return true;
+}
+
+TransformStore::Id TransformStore::getParent(Id id) const{
+    return parents[idToDense[id]];
+}
+
+std::vector<TransformStore::Id> TransformStore::getChildren(Id id) const{
+    std::vector<Id> output;
+    for(Id child = firstChildren[idToDense[id]]; child != INVALID_ID; child = nextSiblings[idToDense[child]])
+        output.push_back(child);
+    return output;
+}
+
+Transform* TransformStore::getOwner(Id id) const{
+    return owners[idToDense[id]];
+}
+
+const Matrix3x4& TransformStore::getLocalMatrix(Id id) const{
+    return localMatrices[idToDense[id]];
+}
+
+const Matrix3x4& TransformStore::getWorldMatrix(Id id) const{
+    return worldMatrices[idToDense[id]];
+}
+
+/// @brief Multiplies two affine matrices
+/// @param a Left hand matrix
+/// @param b Right hand matrix
+/// @param output Matrix to write the result to. Must not alias either input
+static inline void multiplyAffine(const Matrix3x4& a, const Matrix3x4& b, Matrix3x4& output){
+    for(int row = 0; row < 3; row++){
+        for(int col = 0; col < 4; col++){
+            output.m[row][col] = a.m[row][0] * b.m[0][col]
+                + a.m[row][1] * b.m[1][col]
+                + a.m[row][2] * b.m[2][col];
+        }
+        //Translation picks up the implicit fourth row of b
+        output.m[row][3] += a.m[row][3];
+    }
+}
+
+void TransformStore::update(){
+    //Nothing has changed since the last update
+    if(dirtyIds.empty())
+        return;
+
+    //Convert the queued ids to dense indices, skipping released and duplicate entries
+    updateList.clear();
+    for(Id id : dirtyIds){
+        uint32_t dense = idToDense[id];
+        if(dense == INVALID_ID || dirtyFlags[dense] != 1)
+            continue;
+        //Mark as collected so duplicates are skipped
+        dirtyFlags[dense] = 2;
+        updateList.push_back(dense);
+    }
+    dirtyIds.clear();
+
+    //Build all dirty local matrices, split into groups of four across the job system so each batch keeps the SIMD path
+    JobSystem* jobSystem = JobSystem::getActive();
+    if(jobSystem != nullptr && updateList.size() >= PARALLEL_BUILD_THRESHOLD){
+        uint32_t groupCount = static_cast<uint32_t>((updateList.size() + 3) / 4);
+        jobSystem->parallelFor(groupCount, PARALLEL_BUILD_THRESHOLD / 16, [this](uint32_t begin, uint32_t end) {
+            size_t first = static_cast<size_t>(begin) * 4;
+            size_t last = static_cast<size_t>(end) * 4 < updateList.size() ? static_cast<size_t>(end) * 4 : updateList.size();
+            buildLocalMatrices(updateList.data() + first, last - first);
+        });
+    }
+    else
+        buildLocalMatrices(updateList.data(), updateList.size());
+
+    //Flat hierarchy; world matrices are the local matrices
+    if(parentedCount == 0){
+        for(uint32_t dense : updateList){
+            worldMatrices[dense] = localMatrices[dense];
+            dirtyFlags[dense] = 0;
+            changedIds.push_back(denseToId[dense]);
+        }
+        return;
+    }
+
+    //Entries visited by a walk are marked 3, so a dirty entry below an already dirty entry is reached from that ancestor instead
+    size_t firstChanged = changedIds.size();
+    for(uint32_t root : updateList){
+        if(dirtyFlags[root] == 3)
+            continue;
+
+        //Skip entries with a dirty ancestor; the walk from that ancestor rebuilds them
+        Id parent = parents[root];
+        bool hasDirtyAncestor = false;
+        while(parent != INVALID_ID){
+            uint32_t ancestorDense = idToDense[parent];
+            if(dirtyFlags[ancestorDense] != 0){
+                hasDirtyAncestor = true;
+                break;
+            }
+            parent = parents[ancestorDense];
+        }
+        if(hasDirtyAncestor)
+            continue;
+
+        //Walk the subtree parents first so each world matrix is built from an up to date parent
+        traversalStack.push_back(root);
+        while(!traversalStack.empty()){
+            uint32_t dense = traversalStack.back();
+            traversalStack.pop_back();
+
+            Id entryParent = parents[dense];
+            if(entryParent != INVALID_ID)
+                multiplyAffine(worldMatrices[idToDense[entryParent]], localMatrices[dense], worldMatrices[dense]);
+            else
+                worldMatrices[dense] = localMatrices[dense];
+            dirtyFlags[dense] = 3;
+            changedIds.push_back(denseToId[dense]);
+
+            for(Id child = firstChildren[dense]; child != INVALID_ID; child = nextSiblings[idToDense[child]])
+                traversalStack.push_back(idToDense[child]);
+        }
+    }
+
+    //Clear the flags of the visited entries only
+    for(size_t idx = firstChanged; idx < changedIds.size(); idx++)
+        dirtyFlags[idToDense[changedIds[idx]]] = 0;
+}
+
+void TransformStore::collectChangedIds(std::vector<Id>& output){
+    output.insert(output.end(), changedIds.begin(), changedIds.end());
+    changedIds.clear();
+}
+
+uint32_t TransformStore::getIdCount() const{
+    return static_cast<uint32_t>(idToDense.size());
+}
+
+void TransformStore::markDirty(uint32_t dense){
+    if(dirtyFlags[dense] != 0)
+        return;
+
+    dirtyFlags[dense] = 1;
+    dirtyIds.push_back(denseToId[dense]);
+}
+
+void TransformStore::detachFromParent(Id id){
+    uint32_t dense = idToDense[id];
+    Id parent = parents[dense];
+    if(parent == INVALID_ID)
+        return;
+
+    //Unlink the entry from the parent's child list
+    uint32_t parentDense = idToDense[parent];
+    if(firstChildren[parentDense] == id)
+        firstChildren[parentDense] = nextSiblings[dense];
+    else{
+        Id sibling = firstChildren[parentDense];
+        while(nextSiblings[idToDense[sibling]] != id)
+            sibling = nextSiblings[idToDense[sibling]];
+        nextSiblings[idToDense[sibling]] = nextSiblings[dense];
+    }
+
+    parents[dense] = INVALID_ID;
+    nextSiblings[dense] = INVALID_ID;
+    parentedCount--;
+}
+
+/// @brief Builds a single affine matrix from translation, quaternion rotation and scale
+static inline void buildAffine(float tx, float ty, float tz, float qx, float qy, float qz, float qw,
+    float sx, float sy, float sz, Matrix3x4& output){
+    float xx = qx * qx, yy = qy * qy, zz = qz * qz;
+    float xy = qx * qy, xz = qx * qz, yz = qy * qz;
+    float wx = qw * qx, wy = qw * qy, wz = qw * qz;
+
+    output.m[0][0] = (1.0f - 2.0f * (yy + zz)) * sx;
+    output.m[0][1] = (2.0f * (xy - wz)) * sy;
+    output.m[0][2] = (2.0f * (xz + wy)) * sz;
+    output.m[0][3] = tx;
+
+    output.m[1][0] = (2.0f * (xy + wz)) * sx;
+    output.m[1][1] = (1.0f - 2.0f * (xx + zz)) * sy;
+    output.m[1][2] = (2.0f * (yz - wx)) * sz;
+    output.m[1][3] = ty;
+
+    output.m[2][0] = (2.0f * (xz - wy)) * sx;
+    output.m[2][1] = (2.0f * (yz + wx)) * sy;
+    output.m[2][2] = (1.0f - 2.0f * (xx + yy)) * sz;
+    output.m[2][3] = tz;
+}
+
+void TransformStore::buildLocalMatrices(const uint32_t* denseIndices, size_t count){
+    size_t i = 0;
+
+    #ifdef TRANSFORM_STORE_SSE
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+
+    //Build four matrices at a time with each SSE lane holding a different transform
+    for(; i + 4 <= count; i += 4){
+        uint32_t a = denseIndices[i], b = denseIndices[i + 1], c = denseIndices[i + 2], d = denseIndices[i + 3];
+
+        //Gather the components of the four transforms. Lane 0 holds transform a
+        __m128 qx = _mm_set_ps(rotationX[d], rotationX[c], rotationX[b], rotationX[a]);
+        __m128 qy = _mm_set_ps(rotationY[d], rotationY[c], rotationY[b], rotationY[a]);
+        __m128 qz = _mm_set_ps(rotationZ[d], rotationZ[c], rotationZ[b], rotationZ[a]);
+        __m128 qw = _mm_set_ps(rotationW[d], rotationW[c], rotationW[b], rotationW[a]);
+        __m128 sx = _mm_set_ps(scaleX[d], scaleX[c], scaleX[b], scaleX[a]);
+        __m128 sy = _mm_set_ps(scaleY[d], scaleY[c], scaleY[b], scaleY[a]);
+        __m128 sz = _mm_set_ps(scaleZ[d], scaleZ[c], scaleZ[b], scaleZ[a]);
+        __m128 tx = _mm_set_ps(positionX[d], positionX[c], positionX[b], positionX[a]);
+        __m128 ty = _mm_set_ps(positionY[d], positionY[c], positionY[b], positionY[a]);
+        __m128 tz = _mm_set_ps(positionZ[d], positionZ[c], positionZ[b], positionZ[a]);
+
+        __m128 xx = _mm_mul_ps(qx, qx), yy = _mm_mul_ps(qy, qy), zz = _mm_mul_ps(qz, qz);
+        __m128 xy = _mm_mul_ps(qx, qy), xz = _mm_mul_ps(qx, qz), yz = _mm_mul_ps(qy, qz);
+        __m128 wx = _mm_mul_ps(qw, qx), wy = _mm_mul_ps(qw, qy), wz = _mm_mul_ps(qw, qz);
+
+        //Each register holds one matrix element for all four transforms
+        __m128 row0[4] = {
+            _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx),
+            _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy),
+            _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz),
+            tx
+        };
+        __m128 row1[4] = {
+            _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx),
+            _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy),
+            _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz),
+            ty
+        };
+        __m128 row2[4] = {
+            _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx),
+            _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy),
+            _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz),
+            tz
+        };
+
+        //Transpose so each register holds a full matrix row of one transform
+        _MM_TRANSPOSE4_PS(row0[0], row0[1], row0[2], row0[3]);
+        _MM_TRANSPOSE4_PS(row1[0], row1[1], row1[2], row1[3]);
+        _MM_TRANSPOSE4_PS(row2[0], row2[1], row2[2], row2[3]);
+
+        uint32_t targets[4] = {a, b, c, d};
+        for(int lane = 0; lane < 4; lane++){
+            Matrix3x4& output = localMatrices[targets[lane]];
+            _mm_storeu_ps(output.m[0], row0[lane]);
+            _mm_storeu_ps(output.m[1], row1[lane]);
+            _mm_storeu_ps(output.m[2], row2[lane]);
+        }
+    }
+    #endif
+
+    //Remaining transforms, or all of them when SSE is unavailable
+    for(; i < count; i++){
+        uint32_t dense = denseIndices[i];
+        buildAffine(positionX[dense], positionY[dense], positionZ[dense],
+            rotationX[dense], rotationY[dense], rotationZ[dense], rotationW[dense],
+            scaleX[dense], scaleY[dense], scaleZ[dense],
+            localMatrices[dense]);
+    }
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+class Transform;
+
+/// @brief Row major affine matrix. The fourth row is implicitly (0, 0, 0, 1)
+struct alignas(16) Matrix3x4{
+    float m[3][4];
+
+    /// @brief Expands the matrix into a column major glm matrix
+    /// @return
+    glm::mat4 toMat4() const{
+        return glm::mat4(
+            glm::vec4(m[0][0], m[1][0], m[2][0], 0.0f),
+            glm::vec4(m[0][1], m[1][1], m[2][1], 0.0f),
+            glm::vec4(m[0][2], m[1][2], m[2][2], 0.0f),
+            glm::vec4(m[0][3], m[1][3], m[2][3], 1.0f));
+    }
+};
+
+/// @brief Engine owned structure-of-arrays storage for all transform data.
+///     Transform instances are handles holding an id into the store. Ids are stable while the dense arrays are kept packed
+class TransformStore{
+public:
+    using Id = uint32_t;
+    static constexpr Id INVALID_ID = UINT32_MAX;
+    //Number of dirty entries before local matrix building is split across the job system
+    static constexpr uint32_t PARALLEL_BUILD_THRESHOLD = 4096;
+
+    TransformStore();
+    ~TransformStore();
+
+    /// @brief Returns the store that new transforms are allocated from
+    /// @return
+    static TransformStore* getActive();
+
+    /// @brief Sets the store that new transforms are allocated from
+    /// @param store The store to make active
+    static void setActive(TransformStore*);
+
+    /// @brief Allocates an identity transform entry
+    /// @param owner The handle that owns the entry
+    /// @return Returns the id of the new entry
+    Id allocate(Transform*);
+
+    /// @brief Releases an entry. Children of the entry become roots
+    /// @param id The id of the entry to release
+    void release(Id);
+
+    glm::vec3 getPosition(Id) const;
+    void setPosition(Id, glm::vec3);
+
+    glm::quat getRotation(Id) const;
+    void setRotation(Id, glm::quat);
+
+    glm::vec3 getScale(Id) const;
+    void setScale(Id, glm::vec3);
+
+    /// @brief Returns true if the entry has changed since the last update
+    /// @param id The id of the entry
+    /// @return
+    bool isDirty(Id) const;
+
+    /// @brief Sets the parent of an entry
+    /// @param id The id of the child entry
+    /// @param parentId The id of the new parent. INVALID_ID detaches the entry into a root
+    /// @return False if the parent would create a cycle in the hierarchy
+    bool setParent(Id, Id);
+
+    /// @brief Returns the id of an entry's parent or INVALID_ID for roots
+    /// @param id The id of the entry
+    /// @return
+    Id getParent(Id) const;
+
+    /// @brief Returns the ids of an entry's children
+    /// @param id The id of the entry
+    /// @return
+    std::vector<Id> getChildren(Id) const;
+
+    /// @brief Returns the handle that owns an entry
+    /// @param id The id of the entry
+    /// @return
+    Transform* getOwner(Id) const;
+
+    /// @brief Returns the cached local matrix of an entry. Valid until the next update or allocation
+    /// @param id The id of the entry
+    /// @return
+    const Matrix3x4& getLocalMatrix(Id) const;
+
+    /// @brief Returns the cached world matrix of an entry. Valid until the next update or allocation
+    /// @param id The id of the entry
+    /// @return
+    const Matrix3x4& getWorldMatrix(Id) const;
+
+    /// @brief Rebuilds the local matrices of all dirty entries in a batch and then the world matrices of them and their descendants
+    void update();
+
+    /// @brief Moves the ids of every entry whose world matrix was rebuilt since the last call into a list. Ids may repeat and may since have been released
+    /// @param output List the ids are appended to
+    void collectChangedIds(std::vector<Id>&);
+
+    /// @brief Returns one past the largest id handed out so far
+    /// @return
+    uint32_t getIdCount() const;
+
+private:
+    //Position components
+    std::vector<float> positionX, positionY, positionZ;
+    //Rotation quaternion components
+    std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+    //Scale components
+    std::vector<float> scaleX, scaleY, scaleZ;
+    //Output matrices
+    std::vector<Matrix3x4> localMatrices;
+    std::vector<Matrix3x4> worldMatrices;
+
+    //Hierarchy links stored as ids so they survive dense array compaction
+    std::vector<Id> parents;
+    std::vector<Id> firstChildren;
+    std::vector<Id> nextSiblings;
+    //Number of entries that have a parent. Lets flat scenes skip the hierarchy pass
+    uint32_t parentedCount;
+
+    //Dirty flag per dense entry
+    std::vector<uint8_t> dirtyFlags;
+    //Ids flagged dirty since the last update
+    std::vector<Id> dirtyIds;
+    //Ids whose world matrix was rebuilt since the last collectChangedIds
+    std::vector<Id> changedIds;
+
+    //Handle that owns each dense entry
+    std::vector<Transform*> owners;
+
+    //Maps a dense index to its id
+    std::vector<Id> denseToId;
+    //Maps an id to its dense index
+    std::vector<uint32_t> idToDense;
+    //Ids that have been released and can be reused
+    std::vector<Id> freeIds;
+
+    //Scratch list of the dense indices collected for update. Kept to reuse its allocation
+    std::vector<uint32_t> updateList;
+    //Scratch stack of dense indices for walking dirty subtrees during update
+    std::vector<uint32_t> traversalStack;
+
+    //Store new transforms are allocated from
+    static TransformStore* activeStore;
+
+    /// @brief Flags an entry as dirty and queues it for the next update
+    /// @param denseIndex The dense index of the entry
+    void markDirty(uint32_t);
+
+    /// @brief Removes an entry from its parent's child list
+    /// @param id The id of the entry
+    void detachFromParent(Id);
+
+    /// @brief Builds the local matrices of a list of dense entries from their position, rotation and scale
+    /// @param denseIndices Pointer to the dense indices to build
+    /// @param count Number of indices
+    void buildLocalMatrices(const uint32_t*, size_t);
+};
@@ -0,0 +1,315 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <glm/glm.hpp>
+#include "vertex.h"
+
+//Meaning of a vertex attribute
+enum VertexSemantic : uint32_t{
+    SEMANTIC_POSITION,
+    SEMANTIC_COLOR,
+    SEMANTIC_UV,
+    SEMANTIC_NORMAL
+};
+
+//Storage format of a vertex attribute
+enum VertexFormat : uint32_t{
+    //Full precision
+    FORMAT_FLOAT32x2,
+    FORMAT_FLOAT32x3,
+    //Unsigned 16 bit normalized. Positions are stored relative to the mesh bounds; the 4th component is padding
+    FORMAT_UNORM16x4,
+    //Unsigned 8 bit normalized. Used for colors
+    FORMAT_UNORM8x4,
+    //Half precision floats. Used for texture coordinates
+    FORMAT_HALF16x2,
+    //Signed 16 bit normalized. Used for octahedron encoded normals
+    FORMAT_SNORM16x2
+};
+
+/// @brief Returns the size in bytes of a vertex format
+constexpr uint32_t getVertexFormatSize(VertexFormat format){
+    switch(format){
+    case FORMAT_FLOAT32x2: return 8;
+    case FORMAT_FLOAT32x3: return 12;
+    case FORMAT_UNORM16x4: return 8;
+    case FORMAT_UNORM8x4: return 4;
+    case FORMAT_HALF16x2: return 4;
+    case FORMAT_SNORM16x2: return 4;
+    }
+    return 0;
+}
+
+/// @brief Compile time description of a single attribute
+/// @tparam Semantic What the attribute holds
+/// @tparam Format How the attribute is stored
+/// @tparam Location Shader input location of the attribute
+template<VertexSemantic Semantic, VertexFormat Format, uint32_t Location>
+struct VertexAttribute{
+    static constexpr VertexSemantic semantic = Semantic;
+    static constexpr VertexFormat format = Format;
+    static constexpr uint32_t location = Location;
+    static constexpr uint32_t size = getVertexFormatSize(Format);
+};
+
+/// @brief Runtime copy of an attribute's description with its byte offset
+struct VertexAttributeInfo{
+    VertexSemantic semantic;
+    VertexFormat format;
+    uint32_t location;
+    uint32_t offset;
+};
+
+/// @brief Compile time vertex layout. Attributes are packed in the order given; attributes a layout leaves out are simply not stored
+/// @tparam ...Attributes VertexAttribute types making up the vertex
+template<typename... Attributes>
+struct VertexLayout{
+    static constexpr uint32_t attributeCount = sizeof...(Attributes);
+    static constexpr uint32_t stride = (0 + ... + Attributes::size);
+
+    /// @brief Attribute descriptions with offsets calculated from the attribute order
+    static constexpr std::array<VertexAttributeInfo, sizeof...(Attributes)> attributes = []{
+        std::array<VertexAttributeInfo, sizeof...(Attributes)> output{};
+        uint32_t offset = 0;
+        size_t idx = 0;
+        ((output[idx++] = VertexAttributeInfo{Attributes::semantic, Attributes::format, Attributes::location, (offset += Attributes::size) - Attributes::size}), ...);
+        return output;
+    }();
+
+    /// @brief Returns true if the layout stores an attribute with the given semantic
+    static constexpr bool has(VertexSemantic semantic){
+        for(const auto& attribute : attributes){
+            if(attribute.semantic == semantic)
+                return true;
+        }
+        return false;
+    }
+};
+
+/// @brief Helpers converting full precision values to the packed vertex formats
+namespace VertexPacking{
+    /// @brief Converts a float to an IEEE 754 half float, rounding to nearest even
+    inline uint16_t toHalf(float value){
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        uint32_t sign = (bits >> 16) & 0x8000u;
+        int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xFFu) - 127 + 15;
+        uint32_t mantissa = bits & 0x7FFFFFu;
+
+        //NaN and infinity
+        if(((bits >> 23) & 0xFFu) == 0xFFu)
+            return static_cast<uint16_t>(sign | 0x7C00u | (mantissa != 0 ? 0x200u : 0u));
+        //Overflow to infinity
+        if(exponent >= 31)
+            return static_cast<uint16_t>(sign | 0x7C00u);
+        //Subnormal half or zero
+        if(exponent <= 0){
+            if(exponent < -10)
+                return static_cast<uint16_t>(sign);
+            mantissa |= 0x800000u;
+            uint32_t shift = static_cast<uint32_t>(14 - exponent);
+            uint32_t half = mantissa >> shift;
+            uint32_t remainder = mantissa & ((1u << shift) - 1);
+            uint32_t midpoint = 1u << (shift - 1);
+            if(remainder > midpoint || (remainder == midpoint && (half & 1u)))
+                half++;
+            return static_cast<uint16_t>(sign | half);
+        }
+
+        uint32_t half = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+        uint32_t remainder = mantissa & 0x1FFFu;
+        //Rounding may carry into the exponent, which correctly produces the next power of two or infinity
+        if(remainder > 0x1000u || (remainder == 0x1000u && (half & 1u)))
+            half++;
+        return static_cast<uint16_t>(half);
+    }
+
+    /// @brief Converts an IEEE 754 half float back to a float. Exact for every half value
+    inline float fromHalf(uint16_t half){
+        uint32_t sign = static_cast<uint32_t>(half & 0x8000u) << 16;
+        int32_t exponent = (half >> 10) & 0x1F;
+        uint32_t mantissa = half & 0x3FFu;
+
+        uint32_t bits;
+        //NaN and infinity
+        if(exponent == 0x1F)
+            bits = sign | 0x7F800000u | (mantissa << 13);
+        else if(exponent == 0){
+            if(mantissa == 0)
+                bits = sign;
+            else{
+                //Subnormal half; shift the mantissa up until it is normalized
+                exponent = 127 - 15 + 1;
+                while((mantissa & 0x400u) == 0){
+                    mantissa <<= 1;
+                    exponent--;
+                }
+                bits = sign | (static_cast<uint32_t>(exponent) << 23) | ((mantissa & 0x3FFu) << 13);
+            }
+        }
+        else
+            bits = sign | (static_cast<uint32_t>(exponent - 15 + 127) << 23) | (mantissa << 13);
+
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    /// @brief Converts a value in [0, 1] to unsigned normalized 16 bit
+    inline uint16_t toUnorm16(float value){
+        value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+        return static_cast<uint16_t>(std::lround(value * 65535.0f));
+    }
+
+    /// @brief Converts a value in [0, 1] to unsigned normalized 8 bit
+    inline uint8_t toUnorm8(float value){
+        value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+        return static_cast<uint8_t>(std::lround(value * 255.0f));
+    }
+
+    /// @brief Converts a value in [-1, 1] to signed normalized 16 bit
+    inline int16_t toSnorm16(float value){
+        value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+        return static_cast<int16_t>(std::lround(value * 32767.0f));
+    }
+
+    /// @brief Encodes a unit normal onto the octahedron, folding the lower hemisphere over the upper
+    /// @param normal Unit length normal
+    /// @return Returns the encoded normal with both components in [-1, 1]
+    inline glm::vec2 encodeOctNormal(glm::vec3 normal){
+        float length = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+        glm::vec2 encoded(normal.x / length, normal.y / length);
+        if(normal.z < 0.0f){
+            glm::vec2 folded((1.0f - std::fabs(encoded.y)) * (encoded.x >= 0.0f ? 1.0f : -1.0f),
+                (1.0f - std::fabs(encoded.x)) * (encoded.y >= 0.0f ? 1.0f : -1.0f));
+            encoded = folded;
+        }
+        return encoded;
+    }
+
+    /// @brief Decodes a normal encoded by encodeOctNormal. Mirrors the decode done in shaders
+    /// @param encoded The encoded normal
+    /// @return Returns the unit normal
+    inline glm::vec3 decodeOctNormal(glm::vec2 encoded){
+        glm::vec3 normal(encoded.x, encoded.y, 1.0f - std::fabs(encoded.x) - std::fabs(encoded.y));
+        float fold = normal.z < 0.0f ? -normal.z : 0.0f;
+        normal.x += normal.x >= 0.0f ? -fold : fold;
+        normal.y += normal.y >= 0.0f ? -fold : fold;
+        float length = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+        return glm::vec3(normal.x / length, normal.y / length, normal.z / length);
+    }
+
+    /// @brief Writes one vertex in a layout's packed form
+    /// @tparam Layout The VertexLayout to write
+    /// @param vertex The full precision vertex
+    /// @param boundsMin Minimum corner of the bounds positions are quantized against
+    /// @param inverseExtent Reciprocal of the bounds size per axis; 0 for a flat axis
+    /// @param output Destination of Layout::stride bytes
+    template<typename Layout>
+    void writeVertex(const Vertex& vertex, glm::vec3 boundsMin, glm::vec3 inverseExtent, unsigned char* output){
+        for(const auto& attribute : Layout::attributes){
+            unsigned char* destination = output + attribute.offset;
+            switch(attribute.semantic){
+            case SEMANTIC_POSITION:{
+                glm::vec3 relative = (vertex.position - boundsMin) * inverseExtent;
+                if(attribute.format == FORMAT_UNORM16x4){
+                    uint16_t packed[4] = {toUnorm16(relative.x), toUnorm16(relative.y), toUnorm16(relative.z), 0};
+                    std::memcpy(destination, packed, sizeof(packed));
+                }
+                else
+                    std::memcpy(destination, &vertex.position, sizeof(float) * 3);
+                break;
+            }
+            case SEMANTIC_COLOR:{
+                if(attribute.format == FORMAT_UNORM8x4){
+                    uint8_t packed[4] = {toUnorm8(vertex.color.x), toUnorm8(vertex.color.y), toUnorm8(vertex.color.z), 255};
+                    std::memcpy(destination, packed, sizeof(packed));
+                }
+                else
+                    std::memcpy(destination, &vertex.color, sizeof(float) * 3);
+                break;
+            }
+            case SEMANTIC_UV:{
+                if(attribute.format == FORMAT_HALF16x2){
+                    uint16_t packed[2] = {toHalf(vertex.uv.x), toHalf(vertex.uv.y)};
+                    std::memcpy(destination, packed, sizeof(packed));
+                }
+                else
+                    std::memcpy(destination, &vertex.uv, sizeof(float) * 2);
+                break;
+            }
+            case SEMANTIC_NORMAL:{
+                //Vertex carries no normal yet; write the +Z normal so layouts that declare one stay well defined
+                glm::vec2 encoded = encodeOctNormal(glm::vec3(0.0f, 0.0f, 1.0f));
+                int16_t packed[2] = {toSnorm16(encoded.x), toSnorm16(encoded.y)};
+                std::memcpy(destination, packed, sizeof(packed));
+                break;
+            }
+            }
+        }
+    }
+
+    /// @brief Reads one vertex back from a layout's packed form. Attributes the layout doesn't store are left zeroed
+    /// @tparam Layout The VertexLayout to read
+    /// @param input Source of Layout::stride bytes
+    /// @param boundsMin Minimum corner of the bounds positions were quantized against
+    /// @param extent Size of the bounds per axis
+    /// @return Returns the vertex at the precision the layout kept
+    template<typename Layout>
+    Vertex readVertex(const unsigned char* input, glm::vec3 boundsMin, glm::vec3 extent){
+        Vertex vertex{};
+        for(const auto& attribute : Layout::attributes){
+            const unsigned char* source = input + attribute.offset;
+            switch(attribute.semantic){
+            case SEMANTIC_POSITION:{
+                if(attribute.format == FORMAT_UNORM16x4){
+                    uint16_t packed[4];
+                    std::memcpy(packed, source, sizeof(packed));
+                    vertex.position = boundsMin + glm::vec3(packed[0] / 65535.0f, packed[1] / 65535.0f, packed[2] / 65535.0f) * extent;
+                }
+                else
+                    std::memcpy(&vertex.position, source, sizeof(float) * 3);
+                break;
+            }
+            case SEMANTIC_COLOR:{
+                if(attribute.format == FORMAT_UNORM8x4){
+                    uint8_t packed[4];
+                    std::memcpy(packed, source, sizeof(packed));
+                    vertex.color = glm::vec3(packed[0] / 255.0f, packed[1] / 255.0f, packed[2] / 255.0f);
+                }
+                else
+                    std::memcpy(&vertex.color, source, sizeof(float) * 3);
+                break;
+            }
+            case SEMANTIC_UV:{
+                if(attribute.format == FORMAT_HALF16x2){
+                    uint16_t packed[2];
+                    std::memcpy(packed, source, sizeof(packed));
+                    vertex.uv = glm::vec2(fromHalf(packed[0]), fromHalf(packed[1]));
+                }
+                else
+                    std::memcpy(&vertex.uv, source, sizeof(float) * 2);
+                break;
+            }
+            case SEMANTIC_NORMAL:
+                //Vertex carries no normal yet
+                break;
+            }
+        }
+        return vertex;
+    }
+}
+
+/// @brief Layout of the vertices uploaded to the GPU. Half the size of Vertex:
+///     16 bit positions normalized against the mesh bounds, RGBA8 color and half float UVs
+using PackedVertexLayout = VertexLayout<
+    VertexAttribute<SEMANTIC_POSITION, FORMAT_UNORM16x4, 0>,
+    VertexAttribute<SEMANTIC_COLOR, FORMAT_UNORM8x4, 1>,
+    VertexAttribute<SEMANTIC_UV, FORMAT_HALF16x2, 2>
+>;
+
+static_assert(PackedVertexLayout::stride == 16, "Packed vertices are expected to be 16 bytes");
@@ -1,12 +1,19 @@
 #define NDEBUG
 
+#include <algorithm>
 #include <iostream>
 #include <chrono>
+#include <map>
 #include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
 #include "engine_p.h"
 #include "fileio/import_image.h"
 #include "fileio/import_obj.h"
+#include "fileio/import_lbm.h"
 #include "primitives.h"
+#include "meshOptimizer.h"
 #include "rendererData.h"
 #include "input_internal.h"
 
@@ -37,11 +44,17 @@ bool LightbringEngine::start(){
 
     //Initialize any engine data
     try{
+        //Start a worker per hardware thread. The calling thread becomes the job system's main thread
+        pImpl->jobSystem.initialize();
+
         pImpl->initializeWindow(800,600);
         //Initialize the engine's renderer
         pImpl->renderer->initialize(pImpl->window, 800, 600, std::ref(pImpl->windowResizedEvent));
         //Initialize input system
         pImpl->initializeInput(pImpl->window);
+
+        //Hand the initialized renderer to its own thread
+        pImpl->renderThread.start(pImpl->renderer);
     } catch (const std::exception& e){
         std::cerr << e.what() << std::endl;
         shutdown();
@@ -65,26 +78,59 @@ bool LightbringEngine::update(){
         //Update the timestamp for the start of the previous previous frame time to the current frame start time
         pImpl->prevFrameTime = currentTime;
 
+        //Handle what workers posted since the last update, leaving the rest for later updates if many arrived at once
+        pImpl->messageQueue.drain([](const Message& message) { pImpl->handleMessage(message); }, LightbringEngineImpl::MESSAGES_PER_UPDATE);
+
+        //Upload decoded assets within this update's budget
+        pImpl->processPendingUploads();
+
+        //Free released assets the render thread has moved past
+        pImpl->processPendingReleases();
+
         //Update the active scene
         pImpl->activeScene->update(deltaTime);
 
+        //Rebuild the matrices of any transforms changed during the update
+        pImpl->transformStore.update();
+
         
         if(glfwWindowShouldClose(pImpl->window))
             return false;
 
-        glfwPollEvents();
+        //Sleep until the window is restored rather than simulating frames that can't be seen
+        if(pImpl->windowWidth == 0 || pImpl->windowHeight == 0)
+            glfwWaitEvents();
+        else
+            glfwPollEvents();
 
 
-        //Render any active cameras
+        //Stop if the renderer failed on the render thread
+        if(pImpl->renderThread.hasFailed())
+            throw std::runtime_error(pImpl->renderThread.getFailureMessage());
+
+        //Capture the frame for the render thread. The renderer only reads the snapshot so simulation of the next frame can overlap with rendering
+        FrameSnapshot& snapshot = pImpl->renderThread.beginSnapshot();
+
+        //Capture the first active camera as the primary view. Every view fills the whole swap chain image, so further cameras would only overwrite it until views can be composited
         for(auto camera : pImpl->activeScene->sceneCameras){
             if(!camera->getIsRendering())
                 continue;
 
-            //TODO: Renderer preprocessing; eg CPU side object culling
-
-            //Update the renderer and render the next frame
-            pImpl->isRunning = pImpl->renderer->render(camera, pImpl->activeScene->sceneObjects);
+            SnapshotView view;
+            view.viewMatrix = camera->getViewMatrix();
+            view.projectionMatrix = camera->getPerspectiveMatrix();
+            view.viewProjectionMatrix = view.projectionMatrix * view.viewMatrix;
+            snapshot.views.push_back(view);
+            break;
         }
+
+        //Capture the draws of the visible parts of the scene
+        pImpl->captureDraws(snapshot);
+
+        //Hand over the object buffer writes the render thread hasn't seen yet
+        pImpl->captureObjectUpdates(snapshot);
+
+        pImpl->renderThread.submitSnapshot();
     } catch (const std::exception& e){
         std::cerr << e.what() << std::endl;
         shutdown();
@@ -97,6 +143,28 @@ void LightbringEngine::shutdown(){
     //Turn off the running flag
     pImpl->isRunning = false;
 
+    //Stop the render thread before any resources it could be using are released
+    pImpl->renderThread.stop();
+
+    //Let the workers finish outstanding jobs, handling their messages meanwhile so none of them can stall on a full queue
+    while(!pImpl->jobSystem.isIdle()){
+        pImpl->messageQueue.drain([](const Message& message) { pImpl->handleMessage(message); });
+        std::this_thread::yield();
+    }
+
+    //Stop the worker threads
+    pImpl->jobSystem.shutdown();
+
+    //Handle anything the final jobs posted so decoded imports are handed to their handles and released below
+    pImpl->messageQueue.drain([](const Message& message) { pImpl->handleMessage(message); });
+
+    //Uploads still waiting are dropped along with the assets below
+    pImpl->pendingUploads.clear();
+
+    //Free released assets that were still waiting on the render thread, including the static batches
+    pImpl->releaseStaticBatches();
+    pImpl->processPendingReleases(true);
+
     //Clean up any image data
     for(auto texture : pImpl->textures){
         pImpl->renderer->unloadTexture(texture);
@@ -129,17 +197,33 @@ void LightbringEngine::shutdown(){
 Texture* LightbringEngine::importImage(const char* filePath, bool pushToGPU){
     Texture* importedData;
     try{
+        //Share the existing handle if the path or identical file contents have already been imported
+        std::string key = AssetKey::normalizePath(filePath);
+        importedData = pImpl->assetCache.textures.acquireByPath(key);
+        uint64_t contentHash = 0;
+        if(importedData == nullptr){
+            contentHash = AssetKey::hashFile(key);
+            importedData = pImpl->assetCache.textures.acquireByContent(key, contentHash);
+        }
+        if(importedData != nullptr){
+            if(pushToGPU && importedData->getState() == AssetState::ASSET_LOADED)
+                uploadImage(importedData);
+            return importedData;
+        }
+
         //Import the image data from the file
         importedData = importImageFile(filePath);
+        pImpl->assetCache.textures.insert(importedData, key, contentHash);
 
-        //If the data is to be uploaded immediately; do so and clear the CPU data
+        //Add the data structure to the engine's tracker
+        pImpl->textures.push_back(importedData);
+
+        //If the data is to be uploaded immediately; do so and clear the CPU data. A failed upload is evicted from the cache and freed on shutdown
         if(pushToGPU){
-            pImpl->renderer->createTexture(importedData);
+            if(!uploadImage(importedData))
+                return nullptr;
             importedData->pRendererData->releaseRawData();
         }
-
-        //Add the data structure to the engine's tracker
-        pImpl->textures.push_back(importedData);
     }
     catch(const std::exception& e){
         std::cerr << e.what() << std::endl;
@@ -151,17 +235,33 @@ Texture* LightbringEngine::importImage(const char* filePath, bool pushToGPU){
 Mesh* LightbringEngine::importMesh(const char* filePath, bool pushToGPU){
     Mesh* importedData;
     try{
-        //Import the model data from the file
-        importedData = importModelFile(filePath);
-
-        //If the data is to be uploaded immediately; do so and clear the CPU data
-        if(pushToGPU){
-            pImpl->renderer->uploadMesh(importedData);
-            importedData->pRendererData->releaseRawData();
+        //Share the existing handle if the path or identical file contents have already been imported
+        std::string key = AssetKey::normalizePath(filePath);
+        importedData = pImpl->assetCache.meshes.acquireByPath(key);
+        uint64_t contentHash = 0;
+        if(importedData == nullptr){
+            contentHash = getMeshSourceHash(key);
+            importedData = pImpl->assetCache.meshes.acquireByContent(key, contentHash);
         }
+        if(importedData != nullptr){
+            if(pushToGPU && importedData->getState() == AssetState::ASSET_LOADED)
+                uploadMesh(importedData);
+            return importedData;
+        }
+
+        //Import the model data from the file, using its cooked form when up to date
+        importedData = importMeshFile(key.c_str(), contentHash);
+        pImpl->assetCache.meshes.insert(importedData, key, contentHash);
 
         //Add the data structure to the engine's tracker
         pImpl->meshes.push_back(importedData);
+
+        //If the data is to be uploaded immediately; do so and clear the CPU data. A failed upload is evicted from the cache and freed on shutdown
+        if(pushToGPU){
+            if(!uploadMesh(importedData))
+                return nullptr;
+            importedData->pRendererData->releaseRawData();
+        }
     } catch(const std::exception& e){
         std::cerr << e.what() << std::endl;
         return nullptr;
@@ -169,6 +269,103 @@ Mesh* LightbringEngine::importMesh(const char* filePath, bool pushToGPU){
     return importedData;
 }
 
+Mesh* LightbringEngine::importMeshAsync(const char* filePath, bool pushToGPU){
+    //Share the existing handle if the path has already been requested. Contents are only hashed once the worker has read the file
+    std::string path = AssetKey::normalizePath(filePath);
+    Mesh* handle = pImpl->assetCache.meshes.acquireByPath(path);
+    if(handle != nullptr){
+        if(pushToGPU && handle->getState() == AssetState::ASSET_LOADED)
+            pImpl->pendingUploads.push_back({handle, nullptr});
+        return handle;
+    }
+
+    //Create the handle returned to the caller. It is filled in on the main thread once decoding finishes
+    handle = new Mesh();
+    handle->setState(AssetState::ASSET_PENDING);
+    pImpl->meshes.push_back(handle);
+    pImpl->assetCache.meshes.insert(handle, path);
+
+    //Decode on a worker and post the result back to the main thread. Background jobs are never picked up by the main thread while it waits on frame work
+    pImpl->jobSystem.runBackground([handle, path, pushToGPU]() {
+        AssetDecodedPayload payload{handle, nullptr, pushToGPU, 0};
+        try{
+            payload.contentHash = getMeshSourceHash(path);
+            payload.decoded = importMeshFile(path.c_str(), payload.contentHash);
+            pImpl->postAssetMessage(MessageType::MSG_MESH_DECODED, payload);
+        } catch(const std::exception& e){
+            std::cerr << e.what() << std::endl;
+            pImpl->postAssetMessage(MessageType::MSG_MESH_FAILED, payload);
+        }
+    });
+
+    return handle;
+}
+
+Texture* LightbringEngine::importImageAsync(const char* filePath, bool pushToGPU){
+    //Share the existing handle if the path has already been requested. Contents are only hashed once the worker has read the file
+    std::string path = AssetKey::normalizePath(filePath);
+    Texture* handle = pImpl->assetCache.textures.acquireByPath(path);
+    if(handle != nullptr){
+        if(pushToGPU && handle->getState() == AssetState::ASSET_LOADED)
+            pImpl->pendingUploads.push_back({nullptr, handle});
+        return handle;
+    }
+
+    //Create the handle returned to the caller. It is filled in on the main thread once decoding finishes
+    handle = new Texture();
+    handle->setState(AssetState::ASSET_PENDING);
+    pImpl->textures.push_back(handle);
+    pImpl->assetCache.textures.insert(handle, path);
+
+    //Decode on a worker and post the result back to the main thread. Background jobs are never picked up by the main thread while it waits on frame work
+    pImpl->jobSystem.runBackground([handle, path, pushToGPU]() {
+        AssetDecodedPayload payload{handle, nullptr, pushToGPU, 0};
+        Texture* decoded = nullptr;
+        try{
+            payload.contentHash = AssetKey::hashFile(path);
+            decoded = importImageFile(path.c_str());
+            payload.decoded = decoded;
+            pImpl->postAssetMessage(MessageType::MSG_IMAGE_DECODED, payload);
+        } catch(const std::exception& e){
+            std::cerr << e.what() << std::endl;
+            delete decoded;
+            pImpl->postAssetMessage(MessageType::MSG_IMAGE_FAILED, payload);
+        }
+    });
+
+    return handle;
+}
+
+void LightbringEngine::LightbringEngineImpl::postAssetMessage(MessageType type, const AssetDecodedPayload& payload){
+    Message message = Message::create(type, payload);
+
+    //A push only fails on the main thread, which consumes the queue and so can't wait for room. Handle the message right away instead
+    if(!messageQueue.push(message))
+        handleMessage(message);
+}
+
+void LightbringEngine::releaseMesh(Mesh* mesh){
+    if(mesh == nullptr || !pImpl->assetCache.meshes.release(mesh))
+        return;
+
+    //Last reference is gone. Stop tracking the mesh and free it once the render thread can no longer be drawing it
+    auto iterator = std::find(pImpl->meshes.begin(), pImpl->meshes.end(), mesh);
+    if(iterator != pImpl->meshes.end())
+        pImpl->meshes.erase(iterator);
+    pImpl->pendingReleases.push_back({mesh, nullptr, pImpl->renderThread.getNextFrameIndex()});
+}
+
+void LightbringEngine::releaseImage(Texture* image){
+    if(image == nullptr || !pImpl->assetCache.textures.release(image))
+        return;
+
+    //Last reference is gone. Stop tracking the image and free it once the render thread can no longer be sampling it
+    auto iterator = std::find(pImpl->textures.begin(), pImpl->textures.end(), image);
+    if(iterator != pImpl->textures.end())
+        pImpl->textures.erase(iterator);
+    pImpl->pendingReleases.push_back({nullptr, image, pImpl->renderThread.getNextFrameIndex()});
+}
+
 bool LightbringEngine::uploadImage(Texture* imageData){
     //If this image's data has already been registered with the renderer don't upload it again
     if(imageData->pRendererData->rendererData != nullptr)
@@ -176,8 +373,12 @@ bool LightbringEngine::uploadImage(Texture* imageData){
 
     try{
         pImpl->renderer->createTexture(imageData);
+        imageData->setState(AssetState::ASSET_RESIDENT);
     } catch(const std::exception& e){
         std::cerr << e.what() << std::endl;
+        imageData->setState(AssetState::ASSET_FAILED);
+        //Let the next import of the path try again rather than share the failed handle
+        pImpl->assetCache.textures.evict(imageData);
         return false;
     }
     return true;
@@ -185,14 +386,18 @@ bool LightbringEngine::uploadImage(Texture* imageData){
 
 bool LightbringEngine::uploadMesh(Mesh* meshData){
     //If this mesh's data has already been registered with the renderer don't upload it again
-    if(meshData->pRendererData != nullptr)
+    if(meshData->getState() == AssetState::ASSET_RESIDENT)
         return true;
 
     try{
         pImpl->renderer->uploadMesh(meshData);
+        meshData->setState(AssetState::ASSET_RESIDENT);
     } 
     catch(const std::exception& e){
         std::cerr << e.what() << std::endl;
+        meshData->setState(AssetState::ASSET_FAILED);
+        //Let the next import of the path try again rather than share the failed handle
+        pImpl->assetCache.meshes.evict(meshData);
         return false;
     }
     return true;
@@ -203,15 +408,26 @@ Mesh* LightbringEngine::createPrimitive(MeshPrimitive primitive){
     Mesh* output;
 
     //Determine the type of primitive based on input value
+    const Mesh* source;
+    std::string key;
     switch (primitive)
     {
     case MeshPrimitive::PRIM_QUAD:
-        output = new Mesh(quad);
+        source = &quad;
+        key = "primitive:quad";
         break;
     default:
         return nullptr;
     }
 
+    //Every request for a primitive shares a single instance
+    output = pImpl->assetCache.meshes.acquireByPath(key);
+    if(output != nullptr)
+        return output;
+
+    output = new Mesh(*source);
+    pImpl->assetCache.meshes.insert(output, key);
+
     //Add the pointer to the engine's tracker
     pImpl->meshes.push_back(output);
     //Return a pointer to the instance
@@ -246,7 +462,8 @@ void LightbringEngine::setActiveScene(Scene* scene){
         //TODO: Unload active scene data
     }
 
-    //TODO: Load new scene data
+    //Merge the scene's static objects into batches
+    pImpl->buildStaticBatches(scene);
 
     //TODO: Register cameras with renderer
     for(auto camera : pImpl->cameras)
@@ -264,6 +481,7 @@ Material* LightbringEngine::createMaterial(Texture* albedo){
     material->albedo = albedo;
 
     //Add it to the list of materials
+    pImpl->materialIndices[material] = static_cast<uint32_t>(pImpl->materials.size());
     pImpl->materials.push_back(material);
 
     //Return the pointer
@@ -300,6 +518,19 @@ void LightbringEngine::setCameraActive(Camera* camera, bool active){
     camera->setIsRendering(active);
 }
 
+void LightbringEngine::setLodThresholds(const std::vector<float>& thresholds, float hysteresis){
+    pImpl->lodThresholds = thresholds;
+    pImpl->lodHysteresis = hysteresis;
+}
+
+void LightbringEngine::setPreferredDeviceName(std::string name){
+    pImpl->renderer->preferredDeviceName = name;
+}
+
+void LightbringEngine::setPreferredDeviceIndex(uint32_t index){
+    pImpl->renderer->preferredDeviceIndex = index;
+}
+
 void LightbringEngine::setVertexShaderPath(std::string path){
     pImpl->renderer->vertexShaderPath = path;
 }
@@ -315,6 +546,19 @@ LightbringEngine::LightbringEngineImpl::LightbringEngineImpl(){
     #endif
     
     activeScene = nullptr;
+    flaggedScene = nullptr;
+    flaggedObjectCount = 0;
+
+    //Each detail level halves the triangle count, so roughly halve the size each level is used at
+    lodThresholds = {0.25f, 0.12f, 0.06f, 0.03f};
+    lodHysteresis = 0.1f;
+
+    //Make the engine's stores the ones new objects and transforms are allocated from
+    TransformStore::setActive(&transformStore);
+    ComponentRegistry::setActive(&componentRegistry);
+    JobSystem::setActive(&jobSystem);
+    MessageQueue::setActive(&messageQueue);
+    messageQueue.setConsumerThread();
 }
 
 LightbringEngine::LightbringEngineImpl::~LightbringEngineImpl(){
@@ -329,6 +573,480 @@ LightbringEngine::LightbringEngineImpl::~LightbringEngineImpl(){
     glfwTerminate();
 }
 
+void LightbringEngine::LightbringEngineImpl::handleMessage(const Message& message){
+    switch(message.type){
+    case MessageType::MSG_MESH_DECODED:{
+        AssetDecodedPayload payload = message.get<AssetDecodedPayload>();
+        Mesh* target = static_cast<Mesh*>(payload.target);
+        Mesh* decoded = static_cast<Mesh*>(payload.decoded);
+
+        //Record the contents so later imports of identical files from other paths share the handle
+        assetCache.meshes.setContentHash(target, payload.contentHash);
+
+        //Move the decoded data into the handle the caller holds
+        target->takeGeometry(*decoded);
+        delete decoded;
+        target->setState(AssetState::ASSET_LOADED);
+
+        if(payload.pushToGPU)
+            pendingUploads.push_back({target, nullptr});
+        break;
+    }
+    case MessageType::MSG_IMAGE_DECODED:{
+        AssetDecodedPayload payload = message.get<AssetDecodedPayload>();
+        Texture* target = static_cast<Texture*>(payload.target);
+        Texture* decoded = static_cast<Texture*>(payload.decoded);
+
+        //Record the contents so later imports of identical files from other paths share the handle
+        assetCache.textures.setContentHash(target, payload.contentHash);
+
+        //Hand the decoded pixels over to the handle the caller holds
+        target->width = decoded->width;
+        target->height = decoded->height;
+        target->channels = decoded->channels;
+        target->pRendererData->releaseRawData();
+        target->pRendererData->rawData = decoded->pRendererData->rawData;
+        decoded->pRendererData->rawData = nullptr;
+        delete decoded;
+        target->setState(AssetState::ASSET_LOADED);
+
+        if(payload.pushToGPU)
+            pendingUploads.push_back({nullptr, target});
+        break;
+    }
+    //Failed handles are evicted so the next import of the path decodes it again rather than sharing the failure
+    case MessageType::MSG_MESH_FAILED:{
+        Mesh* target = static_cast<Mesh*>(message.get<AssetDecodedPayload>().target);
+        target->setState(AssetState::ASSET_FAILED);
+        assetCache.meshes.evict(target);
+        break;
+    }
+    case MessageType::MSG_IMAGE_FAILED:{
+        Texture* target = static_cast<Texture*>(message.get<AssetDecodedPayload>().target);
+        target->setState(AssetState::ASSET_FAILED);
+        assetCache.textures.evict(target);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void LightbringEngine::LightbringEngineImpl::processPendingUploads(){
+    size_t uploadedBytes = 0;
+    while(!pendingUploads.empty() && uploadedBytes < UPLOAD_BYTES_PER_UPDATE){
+        PendingUpload upload = pendingUploads.front();
+        pendingUploads.pop_front();
+
+        //Skip assets uploaded by an explicit call since they were queued
+        if(upload.mesh != nullptr && upload.mesh->getState() == AssetState::ASSET_LOADED){
+            uploadedBytes += upload.mesh->getVertexDataSize() + upload.mesh->getIndexDataSize();
+            try{
+                renderer->uploadMesh(upload.mesh);
+                upload.mesh->pRendererData->releaseRawData();
+                upload.mesh->setState(AssetState::ASSET_RESIDENT);
+            } catch(const std::exception& e){
+                std::cerr << e.what() << std::endl;
+                upload.mesh->setState(AssetState::ASSET_FAILED);
+                assetCache.meshes.evict(upload.mesh);
+            }
+        }
+        if(upload.texture != nullptr && upload.texture->getState() == AssetState::ASSET_LOADED){
+            uploadedBytes += static_cast<size_t>(upload.texture->width) * upload.texture->height * 4;
+            try{
+                renderer->createTexture(upload.texture);
+                upload.texture->pRendererData->releaseRawData();
+                upload.texture->setState(AssetState::ASSET_RESIDENT);
+            } catch(const std::exception& e){
+                std::cerr << e.what() << std::endl;
+                upload.texture->setState(AssetState::ASSET_FAILED);
+                assetCache.textures.evict(upload.texture);
+            }
+        }
+    }
+}
+
+void LightbringEngine::LightbringEngineImpl::processPendingReleases(bool force){
+    uint64_t renderedFrameCount = renderThread.getRenderedFrameCount();
+    bool renderThreadRunning = renderThread.isRunning();
+
+    for(size_t idx = 0; idx < pendingReleases.size();){
+        PendingRelease& release = pendingReleases[idx];
+
+        //Wait for the render thread to finish the snapshots taken before the release, and for a pending import to hand over its data
+        bool ready = force || !renderThreadRunning || renderedFrameCount > release.frameIndex;
+        if(!force && release.mesh != nullptr && release.mesh->getState() == AssetState::ASSET_PENDING)
+            ready = false;
+        if(!force && release.texture != nullptr && release.texture->getState() == AssetState::ASSET_PENDING)
+            ready = false;
+        if(!ready){
+            idx++;
+            continue;
+        }
+
+        //Drop any upload still queued for the asset
+        pendingUploads.erase(std::remove_if(pendingUploads.begin(), pendingUploads.end(), [&release](const PendingUpload& upload) {
+            return (release.mesh != nullptr && upload.mesh == release.mesh) || (release.texture != nullptr && upload.texture == release.texture);
+        }), pendingUploads.end());
+
+        if(release.mesh != nullptr){
+            renderer->unloadMesh(release.mesh);
+            delete release.mesh;
+        }
+        if(release.texture != nullptr){
+            renderer->unloadTexture(release.texture);
+            delete release.texture;
+        }
+
+        pendingReleases[idx] = pendingReleases.back();
+        pendingReleases.pop_back();
+    }
+}
+
+void LightbringEngine::LightbringEngineImpl::captureDraws(FrameSnapshot& snapshot){
+    cullingViews.clear();
+    cullingDraws.clear();
+    for(const auto& view : snapshot.views)
+        cullingViews.push_back(Culling::makeView(view));
+
+    //Slots of transforms that moved since the last snapshot are rewritten when next gathered
+    changedTransformIds.clear();
+    transformStore.collectChangedIds(changedTransformIds);
+    for(TransformStore::Id id : changedTransformIds){
+        if(id < objectSlotRecords.size())
+            objectSlotRecords[id] = {nullptr, nullptr};
+    }
+
+    //Static batches are already in world space. Whole batches outside every view are skipped before their meshlets are tested
+    uint32_t meshletCount = 0;
+    for(const auto& batch : staticBatches){
+        if(batch.material != nullptr && batch.material->albedo != nullptr && batch.material->albedo->getState() != AssetState::ASSET_RESIDENT)
+            continue;
+
+        Mesh* mesh = batch.mesh;
+        glm::vec3 center = (mesh->boundsMin + mesh->boundsMax) * 0.5f;
+        float radius = glm::length(mesh->boundsMax - mesh->boundsMin) * 0.5f;
+        uint32_t slot = batch.transform->getId();
+        writeObjectSlot(slot, mesh, batch.material, glm::mat4(1.0f), center, radius, snapshot.frameIndex);
+        if(!Culling::isSphereVisible(center, radius, cullingViews.data(), cullingViews.size()))
+            continue;
+
+        cullingDraws.push_back({mesh, batch.material, slot, Culling::makeInstance(glm::mat4(1.0f)), 0, mesh->getIndexCount(), mesh->getMeshlets(), static_cast<uint32_t>(mesh->getMeshletCount()), meshletCount});
+        meshletCount += cullingDraws.back().meshletCount;
+    }
+
+    //Gather the draws of any other objects whose assets are resident on the GPU by walking the mesh pool's dense arrays. Assets still importing are skipped until they are ready
+    updateSceneEntityFlags(activeScene);
+    const ComponentRegistry::ComponentPool& meshPool = componentRegistry.getPool(ComponentType::COMP_MESH);
+    for(size_t poolIdx = 0; poolIdx < meshPool.components.size(); poolIdx++){
+        ComponentRegistry::Entity entity = meshPool.entities[poolIdx];
+        if(entity >= sceneEntityFlags.size() || sceneEntityFlags[entity] != SCENE_ENTITY_PRESENT)
+            continue;
+
+        Mesh* mesh = static_cast<Mesh*>(meshPool.components[poolIdx]);
+        if(mesh->getState() != AssetState::ASSET_RESIDENT)
+            continue;
+
+        Material* material = componentRegistry.getComponent<Material>(entity);
+        if(material != nullptr && material->albedo != nullptr && material->albedo->getState() != AssetState::ASSET_RESIDENT)
+            continue;
+
+        //Meshlet bounds are in the mesh's object space, so they are culled with the object's transform alone
+        Object* object = meshPool.owners[poolIdx];
+        Transform* transform = componentRegistry.getComponent<Transform>(entity);
+        uint32_t slot = transform->getId();
+        CullingDraw draw{mesh, material, slot, Culling::makeInstance(transform->getTransformMatrix()), 0, mesh->getIndexCount(), mesh->getMeshlets(), static_cast<uint32_t>(mesh->getMeshletCount()), meshletCount};
+
+        //The object buffer is persistent, so objects are kept up to date whether or not they are visible
+        glm::vec4 center = draw.instance.modelMatrix * glm::vec4((mesh->boundsMin + mesh->boundsMax) * 0.5f, 1.0f);
+        glm::vec3 worldCenter(center.x, center.y, center.z);
+        float radius = glm::length(mesh->boundsMax - mesh->boundsMin) * 0.5f * draw.instance.maxScale;
+        writeObjectSlot(slot, mesh, material, draw.instance.modelMatrix, worldCenter, radius, snapshot.frameIndex);
+
+        //Skip objects whose bounding sphere is outside every view
+        if(!Culling::isSphereVisible(worldCenter, radius, cullingViews.data(), cullingViews.size()))
+            continue;
+
+        //Narrow the draw to the selected detail level
+        if(mesh->getLodCount() > 0){
+            const MeshLod& lod = mesh->getLods()[selectLodLevel(object, mesh, worldCenter, radius)];
+            draw.firstIndex = lod.firstIndex;
+            draw.indexCount = lod.indexCount;
+            draw.meshlets = mesh->getMeshlets() + lod.firstMeshlet;
+            draw.meshletCount = lod.meshletCount;
+        }
+
+        cullingDraws.push_back(draw);
+        meshletCount += draw.meshletCount;
+    }
+
+    //Test every meshlet of every draw across the workers
+    meshletVisibility.assign(meshletCount, 0);
+    jobSystem.parallelFor(meshletCount, 256, [this](uint32_t begin, uint32_t end){
+        //Find the draw owning the first meshlet of the batch, then walk forwards
+        size_t drawIdx = std::upper_bound(cullingDraws.begin(), cullingDraws.end(), begin,
+            [](uint32_t meshletIdx, const CullingDraw& draw){ return meshletIdx < draw.firstMeshlet; }) - cullingDraws.begin() - 1;
+
+        for(uint32_t meshletIdx = begin; meshletIdx < end; meshletIdx++){
+            while(meshletIdx >= cullingDraws[drawIdx].firstMeshlet + cullingDraws[drawIdx].meshletCount)
+                drawIdx++;
+
+            const CullingDraw& draw = cullingDraws[drawIdx];
+            const Meshlet& meshlet = draw.meshlets[meshletIdx - draw.firstMeshlet];
+            meshletVisibility[meshletIdx] = Culling::isMeshletVisible(meshlet, draw.instance, cullingViews.data(), cullingViews.size()) ? 1 : 0;
+        }
+    });
+
+    //Merge runs of visible meshlets into index ranges. Meshlets are laid out back to back in the index buffer
+    for(const auto& draw : cullingDraws){
+        uint32_t rangeOffset = static_cast<uint32_t>(snapshot.ranges.size());
+
+        if(draw.meshletCount == 0){
+            //Meshes without meshlets are drawn whole
+            snapshot.ranges.push_back({draw.firstIndex, draw.indexCount});
+        }
+        else{
+            for(uint32_t idx = 0; idx < draw.meshletCount; idx++){
+                if(!meshletVisibility[draw.firstMeshlet + idx])
+                    continue;
+
+                const Meshlet& meshlet = draw.meshlets[idx];
+                bool extendsPrevious = snapshot.ranges.size() > rangeOffset
+                    && snapshot.ranges.back().firstIndex + snapshot.ranges.back().indexCount == meshlet.firstIndex;
+                if(extendsPrevious)
+                    snapshot.ranges.back().indexCount += meshlet.indexCount;
+                else
+                    snapshot.ranges.push_back({meshlet.firstIndex, meshlet.indexCount});
+            }
+        }
+
+        uint32_t rangeCount = static_cast<uint32_t>(snapshot.ranges.size()) - rangeOffset;
+        if(rangeCount == 0)
+            continue;
+
+        snapshot.draws.push_back({draw.mesh, draw.material, draw.objectIndex, rangeOffset, rangeCount});
+    }
+}
+
+void LightbringEngine::LightbringEngineImpl::writeObjectSlot(uint32_t slot, const Mesh* mesh, const Material* material, const glm::mat4& modelMatrix, glm::vec3 center, float radius, uint64_t frameIndex){
+    if(slot >= objectSlotRecords.size())
+        objectSlotRecords.resize(static_cast<size_t>(slot) + 1, {nullptr, nullptr});
+
+    //Unchanged since the last write
+    ObjectSlotRecord& record = objectSlotRecords[slot];
+    if(record.mesh == mesh && record.material == material)
+        return;
+    record = {mesh, material};
+
+    SnapshotObjectUpdate update{};
+    update.slot = slot;
+    //Packed vertex positions are relative to the mesh bounds; expand them before the object's transform
+    update.data.modelMatrix = modelMatrix * mesh->getDequantizationMatrix();
+    update.data.boundsSphere = glm::vec4(center, radius);
+    update.data.materialIndex = UINT32_MAX;
+    if(material != nullptr){
+        auto it = materialIndices.find(material);
+        if(it != materialIndices.end())
+            update.data.materialIndex = it->second;
+    }
+
+    //Replace any write to the slot the render thread hasn't acknowledged yet
+    if(slot >= pendingObjectUpdateIndices.size())
+        pendingObjectUpdateIndices.resize(static_cast<size_t>(slot) + 1, UINT32_MAX);
+    uint32_t& pendingIndex = pendingObjectUpdateIndices[slot];
+    if(pendingIndex != UINT32_MAX)
+        pendingObjectUpdates[pendingIndex] = {update, frameIndex};
+    else{
+        pendingIndex = static_cast<uint32_t>(pendingObjectUpdates.size());
+        pendingObjectUpdates.push_back({update, frameIndex});
+    }
+}
+
+void LightbringEngine::LightbringEngineImpl::captureObjectUpdates(FrameSnapshot& snapshot){
+    //Writes captured before the last rendered snapshot were in that snapshot and have been applied
+    uint64_t renderedFrameCount = renderThread.getRenderedFrameCount();
+    for(size_t idx = 0; idx < pendingObjectUpdates.size();){
+        if(pendingObjectUpdates[idx].frameIndex >= renderedFrameCount){
+            idx++;
+            continue;
+        }
+
+        pendingObjectUpdateIndices[pendingObjectUpdates[idx].update.slot] = UINT32_MAX;
+        pendingObjectUpdates[idx] = pendingObjectUpdates.back();
+        pendingObjectUpdates.pop_back();
+        if(idx < pendingObjectUpdates.size())
+            pendingObjectUpdateIndices[pendingObjectUpdates[idx].update.slot] = static_cast<uint32_t>(idx);
+    }
+
+    for(const auto& pending : pendingObjectUpdates)
+        snapshot.objectUpdates.push_back(pending.update);
+    snapshot.objectCount = transformStore.getIdCount();
+}
+
+uint32_t LightbringEngine::LightbringEngineImpl::selectLodLevel(Object* object, const Mesh* mesh, glm::vec3 center, float radius){
+    uint32_t levelCount = static_cast<uint32_t>(mesh->getLodCount());
+    if(levelCount <= 1 || cullingViews.empty())
+        return 0;
+
+    float size = Culling::getProjectedSize(center, radius, cullingViews.data(), cullingViews.size());
+
+    //Levels the size asks for with the thresholds widened either way. Only move once the size is clear of the current level's thresholds
+    uint32_t coarserLevel = 0;
+    uint32_t finerLevel = 0;
+    for(float threshold : lodThresholds){
+        if(size < threshold * (1.0f - lodHysteresis))
+            coarserLevel++;
+        if(size < threshold * (1.0f + lodHysteresis))
+            finerLevel++;
+    }
+
+    uint32_t level = std::min(object->getLodLevel(), levelCount - 1);
+    if(coarserLevel > level)
+        level = coarserLevel;
+    else if(finerLevel < level)
+        level = finerLevel;
+    level = std::min(level, levelCount - 1);
+
+    object->setLodLevel(level);
+    return level;
+}
+
+void LightbringEngine::LightbringEngineImpl::buildStaticBatches(Scene* scene){
+    releaseStaticBatches();
+    if(scene == nullptr)
+        return;
+
+    //Objects placed since the last update haven't had their world matrices built yet
+    transformStore.update();
+
+    //Group the scene's static objects by material and by the cell holding the center of their world space bounds, walking the mesh pool's dense arrays
+    updateSceneEntityFlags(scene);
+    std::map<std::tuple<Material*, int32_t, int32_t, int32_t>, std::vector<std::pair<Object*, Mesh*>>> groups;
+    const ComponentRegistry::ComponentPool& meshPool = componentRegistry.getPool(ComponentType::COMP_MESH);
+    for(size_t poolIdx = 0; poolIdx < meshPool.components.size(); poolIdx++){
+        ComponentRegistry::Entity entity = meshPool.entities[poolIdx];
+        if(entity >= sceneEntityFlags.size() || sceneEntityFlags[entity] == SCENE_ENTITY_ABSENT)
+            continue;
+
+        Object* object = meshPool.owners[poolIdx];
+        if(!object->getIsStatic())
+            continue;
+
+        //Pending imports have no geometry to merge yet
+        Mesh* mesh = static_cast<Mesh*>(meshPool.components[poolIdx]);
+        if(mesh->getState() != AssetState::ASSET_RESIDENT && mesh->getState() != AssetState::ASSET_LOADED)
+            continue;
+
+        glm::vec4 center = componentRegistry.getComponent<Transform>(entity)->getTransformMatrix() * glm::vec4((mesh->boundsMin + mesh->boundsMax) * 0.5f, 1.0f);
+        glm::vec3 cell = glm::floor(glm::vec3(center.x, center.y, center.z) / STATIC_BATCH_CELL_SIZE);
+        groups[std::make_tuple(componentRegistry.getComponent<Material>(entity), static_cast<int32_t>(cell.x), static_cast<int32_t>(cell.y), static_cast<int32_t>(cell.z))].push_back({object, mesh});
+    }
+
+    for(const auto& group : groups){
+        Material* material = std::get<0>(group.first);
+
+        Mesh* batch = nullptr;
+        std::vector<uint32_t> indices;
+        std::vector<Object*> members;
+
+        //Upload the batch being built. Its members keep drawing individually if the upload fails
+        auto finishBatch = [&](){
+            if(batch == nullptr)
+                return;
+
+            batch->setIndices(indices);
+            batch->computeBounds();
+            batch->meshlets = MeshOptimizer::buildMeshlets(batch->vertices, indices);
+            try{
+                renderer->uploadMesh(batch);
+                batch->setState(AssetState::ASSET_RESIDENT);
+                staticBatches.push_back({batch, material, new Transform()});
+                for(const Object* member : members)
+                    sceneEntityFlags[member->getEntity()] = SCENE_ENTITY_BATCHED;
+            } catch(const std::exception& e){
+                std::cerr << e.what() << std::endl;
+                delete batch;
+            }
+
+            batch = nullptr;
+            indices.clear();
+            members.clear();
+        };
+
+        for(const auto& [object, mesh] : group.second){
+            size_t vertexCount = mesh->getVertexCount();
+            if(vertexCount == 0 || vertexCount > STATIC_BATCH_MAX_VERTICES)
+                continue;
+
+            if(batch != nullptr && batch->vertices.size() + vertexCount > STATIC_BATCH_MAX_VERTICES)
+                finishBatch();
+            if(batch == nullptr)
+                batch = new Mesh();
+
+            //Bake the world transform into the vertices
+            glm::mat4 world = object->transform->getTransformMatrix();
+            uint32_t baseVertex = static_cast<uint32_t>(batch->vertices.size());
+            for(size_t idx = 0; idx < vertexCount; idx++){
+                Vertex vertex = mesh->getVertex(idx);
+                glm::vec4 position = world * glm::vec4(vertex.position, 1.0f);
+                vertex.position = glm::vec3(position.x, position.y, position.z);
+                batch->vertices.push_back(vertex);
+            }
+
+            //Batches are drawn at full detail. A mirroring transform reverses the winding, so swap it back
+            uint32_t firstIndex = 0;
+            uint32_t indexCount = mesh->getIndexCount();
+            if(mesh->getLodCount() > 0){
+                firstIndex = mesh->getLods()[0].firstIndex;
+                indexCount = mesh->getLods()[0].indexCount;
+            }
+            bool mirrored = glm::dot(glm::cross(glm::vec3(world[0]), glm::vec3(world[1])), glm::vec3(world[2])) < 0.0f;
+            for(uint32_t idx = firstIndex; idx + 3 <= firstIndex + indexCount; idx += 3){
+                uint32_t a = baseVertex + mesh->getIndex(idx);
+                uint32_t b = baseVertex + mesh->getIndex(idx + 1);
+                uint32_t c = baseVertex + mesh->getIndex(idx + 2);
+                indices.push_back(a);
+                indices.push_back(mirrored ? c : b);
+                indices.push_back(mirrored ? b : c);
+            }
+            members.push_back(object);
+        }
+        finishBatch();
+    }
+}
+
+void LightbringEngine::LightbringEngineImpl::releaseStaticBatches(){
+    for(const auto& batch : staticBatches){
+        pendingReleases.push_back({batch.mesh, nullptr, renderThread.getNextFrameIndex()});
+        delete batch.transform;
+    }
+    staticBatches.clear();
+
+    //Batched objects draw individually again until batches are rebuilt
+    for(uint8_t& flag : sceneEntityFlags){
+        if(flag == SCENE_ENTITY_BATCHED)
+            flag = SCENE_ENTITY_PRESENT;
+    }
+}
+
+void LightbringEngine::LightbringEngineImpl::updateSceneEntityFlags(const Scene* scene){
+    if(scene != flaggedScene){
+        std::fill(sceneEntityFlags.begin(), sceneEntityFlags.end(), SCENE_ENTITY_ABSENT);
+        flaggedScene = scene;
+        flaggedObjectCount = 0;
+    }
+    if(scene == nullptr)
+        return;
+
+    for(; flaggedObjectCount < scene->sceneObjects.size(); flaggedObjectCount++){
+        uint32_t entity = scene->sceneObjects[flaggedObjectCount]->getEntity();
+        if(entity >= sceneEntityFlags.size())
+            sceneEntityFlags.resize(entity + 1, SCENE_ENTITY_ABSENT);
+        if(sceneEntityFlags[entity] == SCENE_ENTITY_ABSENT)
+            sceneEntityFlags[entity] = SCENE_ENTITY_PRESENT;
+    }
+}
+
 void LightbringEngine::LightbringEngineImpl::initializeWindow(const int a_width, const int a_height){
             //Initialize GLFW
         glfwInit();
@@ -361,19 +1079,16 @@ void LightbringEngine::LightbringEngineImpl::framebufferResizeCallback(GLFWwindo
     //Cast the pointer to the engine implementation class
     auto app = reinterpret_cast<LightbringEngineImpl*>(glfwGetWindowUserPointer(a_window));
         
-    //Pauses while the window is minimized
-    glfwGetFramebufferSize(a_window, &a_width, &a_height);
-    while(a_width == 0 || a_height == 0){
-        glfwGetFramebufferSize(a_window, &a_width, &a_height);
-        glfwWaitEvents();
-    }
+    //A minimized window reports a zero size. Update waits for events until it is restored and the renderer skips frames meanwhile
     app->windowWidth = a_width;
     app->windowHeight = a_height;
     //Update the camera aspect ratios
-    float newAspect = (float)a_width / (float)a_height;
-    for(auto camera : app->cameras)
-        camera->setAspectRatio(newAspect);
+    if(a_width > 0 && a_height > 0){
+        float newAspect = (float)a_width / (float)a_height;
+        for(auto camera : app->cameras)
+            camera->setAspectRatio(newAspect);
+    }
 
-    //Invoke the window resize method to inform listening systems of the change
+    //Invoke the window resize method to inform listening systems of the change. The renderer recreates its swap chain at most once per frame however many arrive
     app->windowResizedEvent.Invoke(app->windowWidth, app->windowHeight);
 }
\ No newline at end of file
@@ -0,0 +1,333 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "mesh.h"
+#include "util_io.h"
+#include "import_obj.h"
+#include "meshOptimizer.h"
+#include "vertexLayout.h"
+#include "assetCache.h"
+
+//Cooked Lightbring mesh (.lbm) layout:
+//  LbmHeader at offset 0
+//  Vertex blob at header.vertexOffset, header.vertexCount * header.vertexStride bytes in the packed layout, quantized against the header bounds
+//  Index blob at header.indexOffset, header.indexCount * header.indexSize bytes
+//  Meshlet blob at header.meshletOffset, header.meshletCount Meshlet structures
+//  Detail level blob at header.lodOffset, header.lodCount MeshLod structures
+//Blobs start on LBM_BLOB_ALIGNMENT boundaries so they can be read in place from the mapping. All values are little endian
+
+//Identifies a cooked mesh file
+static constexpr char LBM_MAGIC[4] = {'L', 'B', 'M', '\0'};
+//Incremented whenever the header or blob layout changes. Files with another version are recooked
+static constexpr uint32_t LBM_VERSION = 6;
+//Alignment of the blobs within the file
+static constexpr uint64_t LBM_BLOB_ALIGNMENT = 64;
+//Maximum number of vertex attributes a layout can describe
+static constexpr uint32_t LBM_MAX_ATTRIBUTES = 8;
+
+/// @brief Describes one attribute within a cooked vertex
+struct LbmVertexAttribute{
+    //VertexSemantic of the attribute
+    uint32_t semantic;
+    //VertexFormat of the attribute
+    uint32_t format;
+    //Shader input location
+    uint32_t location;
+    //Byte offset of the attribute within the vertex
+    uint32_t offset;
+};
+
+/// @brief Header at the start of every cooked mesh file
+struct LbmHeader{
+    char magic[4];
+    uint32_t version;
+    //Size of this structure when the file was written
+    uint32_t headerSize;
+
+    //Vertex layout descriptor
+    uint32_t attributeCount;
+    LbmVertexAttribute attributes[LBM_MAX_ATTRIBUTES];
+    uint32_t vertexStride;
+    //Size in bytes of a single index
+    uint32_t indexSize;
+
+    uint64_t vertexCount;
+    uint64_t indexCount;
+
+    //Object space bounds of the vertex positions
+    float boundsMin[3];
+    float boundsMax[3];
+
+    //Byte offsets of the blobs from the start of the file
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t meshletOffset;
+    uint64_t lodOffset;
+
+    uint64_t meshletCount;
+    uint64_t lodCount;
+
+    //Content hash of the source file the mesh was cooked from. Used to detect a stale cook
+    uint64_t sourceHash;
+    //Size and modification time of the source when it was cooked. While both still match the source isn't rehashed
+    uint64_t sourceSize;
+    int64_t sourceModifiedTime;
+};
+
+static_assert(std::is_trivially_copyable<LbmHeader>::value, "LbmHeader is written to disk as raw bytes");
+
+static_assert(std::is_trivially_copyable<Meshlet>::value, "Meshlets are written to disk as raw bytes");
+static_assert(std::is_trivially_copyable<MeshLod>::value, "Detail levels are written to disk as raw bytes");
+
+static_assert(PackedVertexLayout::attributeCount <= LBM_MAX_ATTRIBUTES, "Packed vertex layout has more attributes than a cooked mesh can describe");
+
+/// @brief Fills the layout descriptor of a header with the engine's packed vertex layout
+/// @param header The header to populate
+static void setEngineVertexLayout(LbmHeader& header){
+    std::memset(header.attributes, 0, sizeof(header.attributes));
+    header.attributeCount = PackedVertexLayout::attributeCount;
+    for(uint32_t idx = 0; idx < PackedVertexLayout::attributeCount; idx++){
+        const VertexAttributeInfo& attribute = PackedVertexLayout::attributes[idx];
+        header.attributes[idx] = {attribute.semantic, attribute.format, attribute.location, attribute.offset};
+    }
+    header.vertexStride = PackedVertexLayout::stride;
+}
+
+/// @brief Rounds an offset up to the blob alignment
+static uint64_t alignLbmOffset(uint64_t offset){
+    return (offset + LBM_BLOB_ALIGNMENT - 1) & ~(LBM_BLOB_ALIGNMENT - 1);
+}
+
+/// @brief Returns the path of the cooked file that sits next to a source mesh
+/// @param sourcePath The path of the source mesh
+/// @return
+static std::string getCookedModelPath(const char* sourcePath){
+    return std::filesystem::path(sourcePath).replace_extension(".lbm").string();
+}
+
+/// @brief Reads the size and modification time of a source file
+/// @param sourcePath The path of the source
+/// @param size Set to the size in bytes
+/// @param modifiedTime Set to the modification time in the file clock's ticks
+/// @return False if the file couldn't be queried
+static bool getSourceStamp(const std::string& sourcePath, uint64_t& size, int64_t& modifiedTime){
+    std::error_code error;
+    size = static_cast<uint64_t>(std::filesystem::file_size(sourcePath, error));
+    if(error)
+        return false;
+    modifiedTime = static_cast<int64_t>(std::filesystem::last_write_time(sourcePath, error).time_since_epoch().count());
+    return !error;
+}
+
+/// @brief Returns the content hash of a mesh source. When the cooked file next to it recorded the source's current size and modification time
+///     its stored hash is trusted, so an unchanged source is never read. Otherwise the source is hashed
+/// @param sourcePath The path of the source mesh
+/// @return Returns 0 if the source can't be read
+static uint64_t getMeshSourceHash(const std::string& sourcePath){
+    uint64_t size;
+    int64_t modifiedTime;
+    if(std::filesystem::path(sourcePath).extension() != ".lbm" && getSourceStamp(sourcePath, size, modifiedTime)){
+        std::ifstream cookedFile(getCookedModelPath(sourcePath.c_str()), std::ios::binary);
+        LbmHeader header;
+        if(cookedFile.read(reinterpret_cast<char*>(&header), sizeof(LbmHeader))
+            && std::memcmp(header.magic, LBM_MAGIC, sizeof(LBM_MAGIC)) == 0 && header.version == LBM_VERSION && header.headerSize == sizeof(LbmHeader)
+            && header.sourceHash != 0 && header.sourceSize == size && header.sourceModifiedTime == modifiedTime)
+            return header.sourceHash;
+    }
+
+    return AssetKey::hashFile(sourcePath);
+}
+
+/// @brief Writes a mesh to a cooked mesh file. The file is written to a temporary path and renamed so a partial write is never loaded
+/// @param mesh The mesh to write
+/// @param cookedPath The path of the cooked file
+/// @param sourcePath The path of the file the mesh was imported from
+/// @param sourceHash Content hash of the file the mesh was imported from
+static void writeCookedModelFile(const Mesh* mesh, const std::string& cookedPath, const char* sourcePath, uint64_t sourceHash){
+    LbmHeader header{};
+    std::memcpy(header.magic, LBM_MAGIC, sizeof(LBM_MAGIC));
+    header.version = LBM_VERSION;
+    header.headerSize = sizeof(LbmHeader);
+    setEngineVertexLayout(header);
+
+    header.indexSize = mesh->getIndexType() == IndexType::INDEX_TYPE_UINT32 ? sizeof(uint32_t) : sizeof(uint16_t);
+    header.vertexCount = mesh->getVertexCount();
+    header.indexCount = mesh->getIndexCount();
+    for(int axis = 0; axis < 3; axis++){
+        header.boundsMin[axis] = mesh->boundsMin[axis];
+        header.boundsMax[axis] = mesh->boundsMax[axis];
+    }
+
+    size_t vertexDataSize = mesh->getVertexDataSize();
+    size_t indexDataSize = mesh->getIndexDataSize();
+    header.vertexOffset = alignLbmOffset(sizeof(LbmHeader));
+    header.indexOffset = alignLbmOffset(header.vertexOffset + vertexDataSize);
+    header.meshletCount = mesh->getMeshletCount();
+    size_t meshletDataSize = mesh->getMeshletCount() * sizeof(Meshlet);
+    header.meshletOffset = alignLbmOffset(header.indexOffset + indexDataSize);
+    header.lodCount = mesh->getLodCount();
+    size_t lodDataSize = mesh->getLodCount() * sizeof(MeshLod);
+    header.lodOffset = alignLbmOffset(header.meshletOffset + meshletDataSize);
+    header.sourceHash = sourceHash;
+    //Without a stamp the source is always rehashed, which still catches a stale cook
+    if(!getSourceStamp(sourcePath, header.sourceSize, header.sourceModifiedTime)){
+        header.sourceSize = 0;
+        header.sourceModifiedTime = 0;
+    }
+
+    std::string temporaryPath = cookedPath + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if(!file.is_open())
+            throw std::runtime_error("Failed to create cooked mesh " + temporaryPath);
+
+        //Zero bytes used to pad each blob up to its aligned offset
+        const char padding[LBM_BLOB_ALIGNMENT] = {};
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(LbmHeader));
+        file.write(padding, header.vertexOffset - sizeof(LbmHeader));
+        std::vector<char> packedVertices(vertexDataSize);
+        mesh->writeVertexData(packedVertices.data());
+        file.write(packedVertices.data(), vertexDataSize);
+        file.write(padding, header.indexOffset - header.vertexOffset - vertexDataSize);
+        file.write(static_cast<const char*>(mesh->getIndexData()), indexDataSize);
+        file.write(padding, header.meshletOffset - header.indexOffset - indexDataSize);
+        file.write(reinterpret_cast<const char*>(mesh->getMeshlets()), meshletDataSize);
+        file.write(padding, header.lodOffset - header.meshletOffset - meshletDataSize);
+        file.write(reinterpret_cast<const char*>(mesh->getLods()), lodDataSize);
+
+        if(!file.good())
+            throw std::runtime_error("Failed to write cooked mesh " + temporaryPath);
+    }
+
+    std::filesystem::rename(temporaryPath, cookedPath);
+}
+
+/// @brief Loads a cooked mesh file. The file is memory mapped and the mesh reads its vertices and indices in place, so the
+///     renderer copies them straight from the mapping into staging memory. Meshlets and detail levels are also read in place
+/// @param cookedPath The path of the cooked file
+/// @param expectedSourceHash If not 0 the file is rejected unless it was cooked from a source with this content hash
+/// @return Returns the loaded mesh. Throws if the file is invalid, stale or was written with a different layout
+static Mesh* importCookedModelFile(const char* cookedPath, uint64_t expectedSourceHash = 0){
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(cookedPath);
+
+    if(file->getSize() < sizeof(LbmHeader))
+        throw std::runtime_error(std::string("Cooked mesh is truncated: ") + cookedPath);
+
+    LbmHeader header;
+    std::memcpy(&header, file->getData(), sizeof(LbmHeader));
+
+    if(std::memcmp(header.magic, LBM_MAGIC, sizeof(LBM_MAGIC)) != 0 || header.version != LBM_VERSION || header.headerSize != sizeof(LbmHeader))
+        throw std::runtime_error(std::string("Cooked mesh has an unsupported version: ") + cookedPath);
+
+    if(expectedSourceHash != 0 && header.sourceHash != expectedSourceHash)
+        throw std::runtime_error(std::string("Cooked mesh is out of date: ") + cookedPath);
+
+    //The blobs are used in place, so the layout must match the engine's exactly
+    LbmHeader engineLayout{};
+    setEngineVertexLayout(engineLayout);
+    if(header.attributeCount != engineLayout.attributeCount
+        || std::memcmp(header.attributes, engineLayout.attributes, sizeof(header.attributes)) != 0
+        || header.vertexStride != engineLayout.vertexStride
+        || (header.indexSize != sizeof(uint16_t) && header.indexSize != sizeof(uint32_t)))
+        throw std::runtime_error(std::string("Cooked mesh vertex layout doesn't match the engine: ") + cookedPath);
+
+    //Validate the blob ranges before handing out pointers into the mapping
+    uint64_t vertexDataSize = header.vertexCount * header.vertexStride;
+    uint64_t indexDataSize = header.indexCount * header.indexSize;
+    uint64_t meshletDataSize = header.meshletCount * sizeof(Meshlet);
+    uint64_t lodDataSize = header.lodCount * sizeof(MeshLod);
+    if(header.vertexOffset % LBM_BLOB_ALIGNMENT != 0 || header.indexOffset % LBM_BLOB_ALIGNMENT != 0 || header.meshletOffset % LBM_BLOB_ALIGNMENT != 0
+        || header.lodOffset % LBM_BLOB_ALIGNMENT != 0
+        || header.vertexCount > file->getSize() / header.vertexStride || header.indexCount > file->getSize() / header.indexSize
+        || header.vertexOffset > file->getSize() || vertexDataSize > file->getSize() - header.vertexOffset
+        || header.indexOffset > file->getSize() || indexDataSize > file->getSize() - header.indexOffset
+        || header.meshletCount > file->getSize() / sizeof(Meshlet)
+        || header.meshletOffset > file->getSize() || meshletDataSize > file->getSize() - header.meshletOffset
+        || header.lodCount > file->getSize() / sizeof(MeshLod)
+        || header.lodOffset > file->getSize() || lodDataSize > file->getSize() - header.lodOffset)
+        throw std::runtime_error(std::string("Cooked mesh blobs are out of range: ") + cookedPath);
+
+    //Meshlets index into the index blob, so a corrupt range would draw out of bounds
+    const Meshlet* meshlets = reinterpret_cast<const Meshlet*>(file->getData() + header.meshletOffset);
+    for(uint64_t idx = 0; idx < header.meshletCount; idx++){
+        if(meshlets[idx].firstIndex > header.indexCount || meshlets[idx].indexCount > header.indexCount - meshlets[idx].firstIndex)
+            throw std::runtime_error(std::string("Cooked mesh meshlets are out of range: ") + cookedPath);
+    }
+    const MeshLod* lods = reinterpret_cast<const MeshLod*>(file->getData() + header.lodOffset);
+    for(uint64_t idx = 0; idx < header.lodCount; idx++){
+        if(lods[idx].firstIndex > header.indexCount || lods[idx].indexCount > header.indexCount - lods[idx].firstIndex
+            || lods[idx].firstMeshlet > header.meshletCount || lods[idx].meshletCount > header.meshletCount - lods[idx].firstMeshlet)
+            throw std::runtime_error(std::string("Cooked mesh detail levels are out of range: ") + cookedPath);
+    }
+
+    Mesh* mesh = new Mesh();
+    mesh->mappedData.vertexData = file->getData() + header.vertexOffset;
+    mesh->mappedData.vertexCount = static_cast<size_t>(header.vertexCount);
+    mesh->mappedData.vertexDataSize = static_cast<size_t>(vertexDataSize);
+    mesh->mappedData.indexData = file->getData() + header.indexOffset;
+    mesh->mappedData.indexCount = static_cast<size_t>(header.indexCount);
+    mesh->mappedData.indexDataSize = static_cast<size_t>(indexDataSize);
+    mesh->mappedData.meshletData = header.meshletCount > 0 ? meshlets : nullptr;
+    mesh->mappedData.meshletCount = static_cast<size_t>(header.meshletCount);
+    mesh->mappedData.lodData = header.lodCount > 0 ? lods : nullptr;
+    mesh->mappedData.lodCount = static_cast<size_t>(header.lodCount);
+    mesh->mappedData.indexType = header.indexSize == sizeof(uint32_t) ? IndexType::INDEX_TYPE_UINT32 : IndexType::INDEX_TYPE_UINT16;
+    mesh->mappedData.owner = file;
+    mesh->boundsMin = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+    mesh->boundsMax = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+
+    return mesh;
+}
+
+/// @brief Imports a mesh, preferring its cooked file. OBJ sources are parsed once and cooked to a .lbm file next to them;
+///     later imports load the cooked file as long as it was cooked from the same source contents
+/// @param filePath The path of the mesh. Either a source OBJ or a .lbm file
+/// @param sourceHash Content hash of the file at filePath, as returned by getMeshSourceHash. 0 skips the cooked lookup
+/// @return Returns the imported mesh. Throws if the mesh can't be imported
+static Mesh* importMeshFile(const char* filePath, uint64_t sourceHash){
+    if(std::filesystem::path(filePath).extension() == ".lbm")
+        return importCookedModelFile(filePath);
+
+    std::string cookedPath = getCookedModelPath(filePath);
+
+    //Use the cooked file if it is up to date. Any problem with it falls back to the source and recooks
+    if(sourceHash != 0 && std::filesystem::exists(cookedPath)){
+        try{
+            return importCookedModelFile(cookedPath.c_str(), sourceHash);
+        } catch(const std::exception& e){
+            std::cerr << e.what() << std::endl;
+        }
+    }
+
+    Mesh* mesh = importModelFile(filePath);
+
+    //Weld the per corner vertices and reorder for the post-transform cache before the result is cooked
+    try{
+        MeshOptimizer::optimizeMesh(mesh);
+    } catch(...){
+        delete mesh;
+        throw;
+    }
+    mesh->computeBounds();
+
+    //Failing to cook only costs the next launch a reparse; the imported mesh is still valid
+    if(sourceHash != 0){
+        try{
+            writeCookedModelFile(mesh, cookedPath, filePath, sourceHash);
+        } catch(const std::exception& e){
+            std::cerr << e.what() << std::endl;
+        }
+    }
+
+    return mesh;
+}
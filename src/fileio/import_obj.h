@@ -1,45 +1,408 @@
 #pragma once
-#define TINYOBJLOADER_IMPLEMENTATION
 
+#include <cstdint>
 #include <stdexcept>
-#include <iostream>
-#include <tiny_obj_loader.h>
+#include <string>
+#include <vector>
 #include "mesh.h"
+#include "util_io.h"
+#include "jobSystem.h"
 
+//Files are only split when each chunk would get at least this many bytes
+static constexpr size_t OBJ_MIN_CHUNK_SIZE = 1 << 20;
+
+/// @brief One corner of a face as written in the file. Relative (negative) indices are stored against the start of their chunk until merged
+struct ObjCorner{
+    int64_t position;
+    int64_t texcoord;
+    //OBJ_CORNER_* flags
+    uint8_t flags;
+};
+
+//Corner flags
+static constexpr uint8_t OBJ_CORNER_RELATIVE_POSITION = 1 << 0;
+static constexpr uint8_t OBJ_CORNER_RELATIVE_TEXCOORD = 1 << 1;
+static constexpr uint8_t OBJ_CORNER_HAS_TEXCOORD = 1 << 2;
+
+/// @brief Attributes and triangulated faces parsed from one chunk of the file
+struct ObjChunk{
+    const char* begin;
+    const char* end;
+
+    //xyz per position
+    std::vector<float> positions;
+    //uv per texture coordinate
+    std::vector<float> texcoords;
+    //Three corners per triangle
+    std::vector<ObjCorner> corners;
+
+    //Number of positions and texcoords declared by earlier chunks
+    int64_t positionBase;
+    int64_t texcoordBase;
+    //Index of the chunk's first corner in the merged mesh
+    size_t cornerBase;
+
+    //Set if the chunk failed to parse
+    std::string error;
+};
+
+/// @brief Advances past spaces and tabs
+static inline void skipObjWhitespace(const char*& cursor, const char* end){
+    while(cursor < end && (*cursor == ' ' || *cursor == '\t'))
+        cursor++;
+}
+
+/// @brief Advances to the first character of the next line
+static inline void skipObjLine(const char*& cursor, const char* end){
+    while(cursor < end && *cursor != '\n')
+        cursor++;
+    if(cursor < end)
+        cursor++;
+}
+
+/// @brief Parses a decimal float without locale handling or allocation. Accumulates up to 19 significant digits and scales by a power of ten table,
+///     which is well within float precision
+/// @param cursor Start of the number. Advanced past it on success
+/// @param end End of the readable range
+/// @param output Receives the parsed value
+/// @return False if no number was found
+static bool parseObjFloat(const char*& cursor, const char* end, float& output){
+    static const double powersOfTen[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char* start = cursor;
+    bool negative = false;
+    if(cursor < end && (*cursor == '-' || *cursor == '+')){
+        negative = *cursor == '-';
+        cursor++;
+    }
+
+    uint64_t mantissa = 0;
+    int digitCount = 0;
+    int exponent = 0;
+    bool hasDigits = false;
+
+    //Integer part. Digits beyond the 19th only shift the exponent
+    while(cursor < end && *cursor >= '0' && *cursor <= '9'){
+        if(digitCount < 19){
+            mantissa = mantissa * 10 + (*cursor - '0');
+            if(mantissa != 0)
+                digitCount++;
+        }
+        else
+            exponent++;
+        hasDigits = true;
+        cursor++;
+    }
+
+    //Fractional part
+    if(cursor < end && *cursor == '.'){
+        cursor++;
+        while(cursor < end && *cursor >= '0' && *cursor <= '9'){
+            if(digitCount < 19){
+                mantissa = mantissa * 10 + (*cursor - '0');
+                if(mantissa != 0)
+                    digitCount++;
+                exponent--;
+            }
+            hasDigits = true;
+            cursor++;
+        }
+    }
+
+    if(!hasDigits){
+        cursor = start;
+        return false;
+    }
+
+    //Exponent
+    if(cursor < end && (*cursor == 'e' || *cursor == 'E')){
+        const char* exponentStart = cursor;
+        cursor++;
+        bool negativeExponent = false;
+        if(cursor < end && (*cursor == '-' || *cursor == '+')){
+            negativeExponent = *cursor == '-';
+            cursor++;
+        }
+        if(cursor < end && *cursor >= '0' && *cursor <= '9'){
+            int exponentValue = 0;
+            while(cursor < end && *cursor >= '0' && *cursor <= '9'){
+                if(exponentValue < 10000)
+                    exponentValue = exponentValue * 10 + (*cursor - '0');
+                cursor++;
+            }
+            exponent += negativeExponent ? -exponentValue : exponentValue;
+        }
+        //Not an exponent after all, leave the 'e' unread
+        else
+            cursor = exponentStart;
+    }
+
+    double value = static_cast<double>(mantissa);
+    while(exponent > 22){
+        value *= 1e22;
+        exponent -= 22;
+    }
+    while(exponent < -22){
+        value /= 1e22;
+        exponent += 22;
+    }
+    value = exponent >= 0 ? value * powersOfTen[exponent] : value / powersOfTen[-exponent];
+
+    output = static_cast<float>(negative ? -value : value);
+    return true;
+}
+
+/// @brief Parses a signed integer face index
+/// @return False if no integer was found
+static bool parseObjIndex(const char*& cursor, const char* end, int64_t& output){
+    bool negative = false;
+    if(cursor < end && (*cursor == '-' || *cursor == '+')){
+        negative = *cursor == '-';
+        cursor++;
+    }
+    if(cursor >= end || *cursor < '0' || *cursor > '9')
+        return false;
+
+    int64_t value = 0;
+    while(cursor < end && *cursor >= '0' && *cursor <= '9'){
+        value = value * 10 + (*cursor - '0');
+        cursor++;
+    }
+    output = negative ? -value : value;
+    return true;
+}
+
+/// @brief Converts a face index from the file into a 0 based index. Negative indices count back from the attributes declared so far in the chunk
+/// @param value The index as written in the file
+/// @param localCount Number of attributes of the same kind declared so far in the chunk
+/// @param relative Set if the result is relative to the start of the chunk
+/// @return
+static inline int64_t resolveObjIndex(int64_t value, int64_t localCount, bool& relative){
+    relative = value < 0;
+    return relative ? localCount + value : value - 1;
+}
+
+/// @brief Parses the vertex positions, texture coordinates and faces of one chunk. Faces with more than three corners are triangulated as fans
+/// @param chunk The chunk to parse
+static void parseObjChunk(ObjChunk& chunk){
+    const char* cursor = chunk.begin;
+    const char* end = chunk.end;
+
+    //Corners of the face being read, reused between faces
+    std::vector<ObjCorner> faceCorners;
+
+    while(cursor < end){
+        skipObjWhitespace(cursor, end);
+        if(cursor >= end)
+            break;
+
+        if(cursor[0] == 'v' && cursor + 1 < end && (cursor[1] == ' ' || cursor[1] == '\t')){
+            //Vertex position. Any w or color components after xyz are ignored
+            cursor++;
+            float value[3];
+            for(int idx = 0; idx < 3; idx++){
+                skipObjWhitespace(cursor, end);
+                if(!parseObjFloat(cursor, end, value[idx])){
+                    chunk.error = "Failed to parse OBJ vertex position";
+                    return;
+                }
+            }
+            chunk.positions.insert(chunk.positions.end(), value, value + 3);
+        }
+        else if(cursor[0] == 'v' && cursor + 2 < end && cursor[1] == 't' && (cursor[2] == ' ' || cursor[2] == '\t')){
+            //Texture coordinate. v is optional and defaults to 0. Any w component is ignored
+            cursor += 2;
+            float value[2] = {0.0f, 0.0f};
+            skipObjWhitespace(cursor, end);
+            if(!parseObjFloat(cursor, end, value[0])){
+                chunk.error = "Failed to parse OBJ texture coordinate";
+                return;
+            }
+            skipObjWhitespace(cursor, end);
+            parseObjFloat(cursor, end, value[1]);
+            chunk.texcoords.insert(chunk.texcoords.end(), value, value + 2);
+        }
+        else if(cursor[0] == 'f' && cursor + 1 < end && (cursor[1] == ' ' || cursor[1] == '\t')){
+            //Face made of v, v/vt, v//vn or v/vt/vn corners
+            cursor++;
+            faceCorners.clear();
+            int64_t localPositions = static_cast<int64_t>(chunk.positions.size() / 3);
+            int64_t localTexcoords = static_cast<int64_t>(chunk.texcoords.size() / 2);
+
+            while(true){
+                skipObjWhitespace(cursor, end);
+                if(cursor >= end || *cursor == '\n' || *cursor == '\r' || *cursor == '#')
+                    break;
+
+                ObjCorner corner{0, 0, 0};
+                int64_t value;
+                bool relative;
+                if(!parseObjIndex(cursor, end, value)){
+                    chunk.error = "Failed to parse OBJ face";
+                    return;
+                }
+                corner.position = resolveObjIndex(value, localPositions, relative);
+                if(relative)
+                    corner.flags |= OBJ_CORNER_RELATIVE_POSITION;
+
+                if(cursor < end && *cursor == '/'){
+                    cursor++;
+                    if(cursor < end && *cursor != '/'){
+                        if(!parseObjIndex(cursor, end, value)){
+                            chunk.error = "Failed to parse OBJ face";
+                            return;
+                        }
+                        corner.texcoord = resolveObjIndex(value, localTexcoords, relative);
+                        corner.flags |= OBJ_CORNER_HAS_TEXCOORD;
+                        if(relative)
+                            corner.flags |= OBJ_CORNER_RELATIVE_TEXCOORD;
+                    }
+                    //Normals aren't used by the vertex format; skip the index
+                    if(cursor < end && *cursor == '/'){
+                        cursor++;
+                        parseObjIndex(cursor, end, value);
+                    }
+                }
+
+                faceCorners.push_back(corner);
+            }
+
+            if(faceCorners.size() < 3){
+                chunk.error = "OBJ face has fewer than three corners";
+                return;
+            }
+            for(size_t idx = 1; idx + 1 < faceCorners.size(); idx++){
+                chunk.corners.push_back(faceCorners[0]);
+                chunk.corners.push_back(faceCorners[idx]);
+                chunk.corners.push_back(faceCorners[idx + 1]);
+            }
+        }
+
+        //Anything else (normals, groups, materials, comments) is skipped along with the rest of the line
+        skipObjLine(cursor, end);
+    }
+}
+
+/// @brief Imports an OBJ model. The file is memory mapped, split at line boundaries and the chunks are parsed in parallel on the active job system
+/// @param modelPath The path of the model
+/// @return Returns the imported mesh with one vertex per face corner. Throws if the file can't be read or parsed
 static Mesh* importModelFile(const char* modelPath){
-    Mesh* mesh = new Mesh();
+    MappedFile file(modelPath);
+    const char* data = reinterpret_cast<const char*>(file.getData());
+    size_t size = file.getSize();
+
+    JobSystem* jobSystem = JobSystem::getActive();
+    uint32_t threadCount = jobSystem != nullptr ? jobSystem->getWorkerCount() + 1 : 1;
+
+    //A few chunks per thread lets faster threads pick up the slack
+    size_t chunkCount = size / OBJ_MIN_CHUNK_SIZE;
+    if(chunkCount > threadCount * 4)
+        chunkCount = threadCount * 4;
+    if(chunkCount == 0)
+        chunkCount = 1;
+
+    //Split at line boundaries so no line spans two chunks
+    std::vector<ObjChunk> chunks(chunkCount);
+    const char* chunkBegin = data;
+    for(size_t idx = 0; idx < chunkCount; idx++){
+        const char* chunkEnd = data + size * (idx + 1) / chunkCount;
+        if(chunkEnd < chunkBegin)
+            chunkEnd = chunkBegin;
+        while(chunkEnd < data + size && (chunkEnd == data || chunkEnd[-1] != '\n'))
+            chunkEnd++;
+        chunks[idx].begin = chunkBegin;
+        chunks[idx].end = chunkEnd;
+        chunkBegin = chunkEnd;
+    }
+
+    auto forEachChunk = [&](auto function){
+        if(jobSystem != nullptr)
+            jobSystem->parallelFor(static_cast<uint32_t>(chunkCount), 1, [&](uint32_t begin, uint32_t end){
+                for(uint32_t idx = begin; idx < end; idx++)
+                    function(chunks[idx]);
+            });
+        else
+            for(auto& chunk : chunks)
+                function(chunk);
+    };
 
-    tinyobj::attrib_t attrib;
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
-    std::string warn,err;
+    forEachChunk([](ObjChunk& chunk){ parseObjChunk(chunk); });
 
-    if(!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, modelPath)){
-        throw std::runtime_error(warn + err);
+    //Offset each chunk's indices by the attributes declared before it
+    int64_t positionCount = 0;
+    int64_t texcoordCount = 0;
+    size_t cornerCount = 0;
+    for(auto& chunk : chunks){
+        if(!chunk.error.empty())
+            throw std::runtime_error(chunk.error + " in " + modelPath);
+
+        chunk.positionBase = positionCount;
+        chunk.texcoordBase = texcoordCount;
+        chunk.cornerBase = cornerCount;
+        positionCount += static_cast<int64_t>(chunk.positions.size() / 3);
+        texcoordCount += static_cast<int64_t>(chunk.texcoords.size() / 2);
+        cornerCount += chunk.corners.size();
     }
 
-    for(const auto& shape : shapes){
-        for(const auto& index : shape.mesh.indices){
-            Vertex vertex{};
-            
-            vertex.position = {
-                attrib.vertices[3 * index.vertex_index + 0],
-                attrib.vertices[3 * index.vertex_index + 1],
-                attrib.vertices[3 * index.vertex_index + 2]
-            };
+    //Gather the attributes into contiguous arrays so faces can reference any chunk
+    std::vector<float> positions;
+    std::vector<float> texcoords;
+    positions.reserve(static_cast<size_t>(positionCount) * 3);
+    texcoords.reserve(static_cast<size_t>(texcoordCount) * 2);
+    for(const auto& chunk : chunks){
+        positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+        texcoords.insert(texcoords.end(), chunk.texcoords.begin(), chunk.texcoords.end());
+    }
 
-            vertex.uv = {
-                attrib.texcoords[2 * index.texcoord_index + 0],
+    //Build one vertex per corner, each chunk writing its own range
+    Mesh* mesh = new Mesh();
+    mesh->vertices.resize(cornerCount);
+    std::vector<uint32_t> indices(cornerCount);
+
+    std::vector<char> rangeErrors(chunkCount, 0);
+    forEachChunk([&](ObjChunk& chunk){
+        size_t chunkIndex = &chunk - chunks.data();
+        for(size_t idx = 0; idx < chunk.corners.size(); idx++){
+            const ObjCorner& corner = chunk.corners[idx];
+            size_t output = chunk.cornerBase + idx;
+
+            int64_t position = (corner.flags & OBJ_CORNER_RELATIVE_POSITION) ? chunk.positionBase + corner.position : corner.position;
+            if(position < 0 || position >= positionCount){
+                rangeErrors[chunkIndex] = 1;
+                return;
+            }
+
+            Vertex& vertex = mesh->vertices[output];
+            vertex.position = {positions[3 * position + 0], positions[3 * position + 1], positions[3 * position + 2]};
+
+            vertex.uv = {0.0f, 0.0f};
+            if(corner.flags & OBJ_CORNER_HAS_TEXCOORD){
+                int64_t texcoord = (corner.flags & OBJ_CORNER_RELATIVE_TEXCOORD) ? chunk.texcoordBase + corner.texcoord : corner.texcoord;
+                if(texcoord < 0 || texcoord >= texcoordCount){
+                    rangeErrors[chunkIndex] = 1;
+                    return;
+                }
                 //Flip Y tex coord to match Y flip of renderer
-                1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
-            };
+                vertex.uv = {texcoords[2 * texcoord + 0], 1.0f - texcoords[2 * texcoord + 1]};
+            }
 
             vertex.color = {1.0f, 1.0f, 1.0f};
+            indices[output] = static_cast<uint32_t>(output);
+        }
+    });
 
-            mesh->vertices.push_back(vertex);
-            mesh->indices.push_back(mesh->indices.size());
+    for(char rangeError : rangeErrors){
+        if(rangeError){
+            delete mesh;
+            throw std::runtime_error(std::string("OBJ face index out of range in ") + modelPath);
         }
     }
 
+    //Every corner is its own vertex until the mesh is welded, so large files start out with 32 bit indices
+    mesh->setIndices(indices);
+
     return mesh;
-}
\ No newline at end of file
+}
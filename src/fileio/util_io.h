@@ -2,6 +2,23 @@
 
 #include <vector>
 #include <fstream>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 /// @brief Helper function to open and read a file
 /// @param filename 
@@ -28,4 +45,111 @@ static std::vector<char> readFile(const std::string& filename){
     file.close();
 
     return buffer;
-}
\ No newline at end of file
+}
+
+/// @brief Read-only memory mapping of an entire file. Pages are loaded by the OS on first access and can be dropped under memory pressure
+class MappedFile{
+public:
+    /// @brief Maps a file into memory
+    /// @param filename The file to map
+    MappedFile(const std::string& filename) : data(nullptr), size(0){
+    #ifdef _WIN32
+        fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        mappingHandle = nullptr;
+        if(fileHandle == INVALID_HANDLE_VALUE)
+            throw std::runtime_error("Failed to open file " + filename);
+
+        LARGE_INTEGER fileSize;
+        if(!GetFileSizeEx(fileHandle, &fileSize)){
+            close();
+            throw std::runtime_error("Failed to get size of file " + filename);
+        }
+        size = static_cast<size_t>(fileSize.QuadPart);
+
+        //Mapping an empty file is an error on Windows; leave the data null instead
+        if(size == 0)
+            return;
+
+        mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if(mappingHandle != nullptr)
+            data = static_cast<const unsigned char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        if(data == nullptr){
+            close();
+            throw std::runtime_error("Failed to map file " + filename);
+        }
+    #else
+        fileDescriptor = ::open(filename.c_str(), O_RDONLY);
+        if(fileDescriptor < 0)
+            throw std::runtime_error("Failed to open file " + filename);
+
+        struct stat fileStat;
+        if(fstat(fileDescriptor, &fileStat) != 0){
+            close();
+            throw std::runtime_error("Failed to get size of file " + filename);
+        }
+        size = static_cast<size_t>(fileStat.st_size);
+
+        //Mapping zero bytes is an error; leave the data null instead
+        if(size == 0)
+            return;
+
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+        if(mapping == MAP_FAILED){
+            close();
+            throw std::runtime_error("Failed to map file " + filename);
+        }
+        data = static_cast<const unsigned char*>(mapping);
+    #endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile(){
+        close();
+    }
+
+    /// @brief Returns a pointer to the start of the mapped file. Nullptr for an empty file
+    /// @return
+    const unsigned char* getData() const{
+        return data;
+    }
+
+    /// @brief Returns the size of the file in bytes
+    /// @return
+    size_t getSize() const{
+        return size;
+    }
+
+private:
+    const unsigned char* data;
+    size_t size;
+
+#ifdef _WIN32
+    HANDLE fileHandle;
+    HANDLE mappingHandle;
+#else
+    int fileDescriptor;
+#endif
+
+    /// @brief Unmaps the file and closes its handles
+    void close(){
+    #ifdef _WIN32
+        if(data != nullptr)
+            UnmapViewOfFile(data);
+        if(mappingHandle != nullptr)
+            CloseHandle(mappingHandle);
+        if(fileHandle != INVALID_HANDLE_VALUE)
+            CloseHandle(fileHandle);
+        mappingHandle = nullptr;
+        fileHandle = INVALID_HANDLE_VALUE;
+    #else
+        if(data != nullptr)
+            munmap(const_cast<unsigned char*>(data), size);
+        if(fileDescriptor >= 0)
+            ::close(fileDescriptor);
+        fileDescriptor = -1;
+    #endif
+        data = nullptr;
+    }
+};
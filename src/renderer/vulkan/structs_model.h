@@ -3,52 +3,57 @@
 #include <array>
 #include <glm/glm.hpp>
 #include <vulkan/vulkan_core.h>
+#include "vertexLayout.h"
 
-/// @brief Defines a vertex to be used with Vulkan
-class VkVertex : Vertex {
+/// @brief Returns the Vulkan format matching a vertex attribute format
+/// @param format The engine vertex format
+/// @return
+constexpr VkFormat getVkVertexFormat(VertexFormat format){
+    switch(format){
+    case FORMAT_FLOAT32x2: return VK_FORMAT_R32G32_SFLOAT;
+    case FORMAT_FLOAT32x3: return VK_FORMAT_R32G32B32_SFLOAT;
+    case FORMAT_UNORM16x4: return VK_FORMAT_R16G16B16A16_UNORM;
+    case FORMAT_UNORM8x4: return VK_FORMAT_R8G8B8A8_UNORM;
+    case FORMAT_HALF16x2: return VK_FORMAT_R16G16_SFLOAT;
+    case FORMAT_SNORM16x2: return VK_FORMAT_R16G16_SNORM;
+    }
+    return VK_FORMAT_UNDEFINED;
+}
+
+/// @brief Generates the Vulkan vertex input descriptions of a VertexLayout at compile time
+/// @tparam Layout The VertexLayout describing the vertex
+template<typename Layout>
+class VkVertexLayout{
 public:
     /// @brief Method to inform Vulkan the size of the data and at what rate to load it
     /// @return 
-    static VkVertexInputBindingDescription getBindingDescription(){
+    static constexpr VkVertexInputBindingDescription getBindingDescription(){
         VkVertexInputBindingDescription bindingDescription{};
         //Index of the binding in the array of bindings
         bindingDescription.binding = 0;
         //Size of each per-vertex data entry
-        bindingDescription.stride = sizeof(Vertex);
+        bindingDescription.stride = Layout::stride;
         //Rate to move to next data entry. _INSTANCE used with instanced rendering
         bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
         return bindingDescription;
     }
 
-    /// @brief 
+    /// @brief Describes every attribute of the layout
     /// @return 
-    static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions(){
-        //Array that contains the attribute descriptions of the Vertex structure
-        std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions{};
-        //Position data description
-        //Index to binding that Vulkan will use
-        attributeDescriptions[0].binding = 0;
-        //Index to location directive used in vertex shader
-        attributeDescriptions[0].location = 0;
-        //Describes type of data for the attribute. Implicitly defines the byte size of the attribute data
-        attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-        //Specifies the number of bytes since the start of the per-vertex data
-        attributeDescriptions[0].offset = offsetof(Vertex, position);
-
-        //Color data description
-        attributeDescriptions[1].binding = 0;
-        attributeDescriptions[1].location = 1;
-        attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-        attributeDescriptions[1].offset = offsetof(Vertex, color);
-
-        //Texture coordinate description
-        attributeDescriptions[2].binding = 0;
-        attributeDescriptions[2].location = 2;
-        attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-        attributeDescriptions[2].offset = offsetof(Vertex, uv);
-        
+    static constexpr std::array<VkVertexInputAttributeDescription, Layout::attributeCount> getAttributeDescriptions(){
+        std::array<VkVertexInputAttributeDescription, Layout::attributeCount> attributeDescriptions{};
+        for(size_t idx = 0; idx < Layout::attributeCount; idx++){
+            //Index to binding that Vulkan will use
+            attributeDescriptions[idx].binding = 0;
+            //Index to location directive used in vertex shader
+            attributeDescriptions[idx].location = Layout::attributes[idx].location;
+            //Describes type of data for the attribute. Implicitly defines the byte size of the attribute data
+            attributeDescriptions[idx].format = getVkVertexFormat(Layout::attributes[idx].format);
+            //Specifies the number of bytes since the start of the per-vertex data
+            attributeDescriptions[idx].offset = Layout::attributes[idx].offset;
+        }
 
         return attributeDescriptions;
     }
-};
\ No newline at end of file
+};
@@ -1,5 +1,12 @@
 #pragma once
+#include <atomic>
+#include <deque>
+#include <mutex>
 #include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 
 //Container for supported swap chain features
 struct SwapChainSupportDetails{
@@ -35,15 +42,35 @@ struct QueueFamilyIndices{
     }
 };
 
+//Capabilities of a physical device. Stored for the device in use so optional fast paths can check them at runtime
+struct DeviceCapabilities{
+    //Name reported by the driver
+    std::string name;
+    VkPhysicalDeviceType deviceType = VK_PHYSICAL_DEVICE_TYPE_OTHER;
+    //Vulkan version supported by the device
+    uint32_t apiVersion = 0;
+    //Size in bytes of the largest device local memory heap
+    VkDeviceSize deviceLocalMemory = 0;
+    //Features only reported through the Vulkan 1.2 feature query; false on older devices and instances
+    bool descriptorIndexing = false;
+    bool timelineSemaphores = false;
+    //True if BC compressed textures can be sampled
+    bool textureCompressionBC = false;
+    //True if a queue family supports transfers but not graphics, letting uploads run alongside rendering
+    bool dedicatedTransferQueue = false;
+    //True if a queue family supports compute but not graphics
+    bool dedicatedComputeQueue = false;
+};
+
 struct BufferSet{
     //Stores the buffer handle
     VkBuffer buffer;
     //Stores the device memory handle
     VkDeviceMemory memory;
 
+    /// @brief Destroys the buffer and frees its memory. The GPU must have finished with it; use VulkanRenderer::retireBuffer otherwise
+    /// @param device The logical device the buffer exists on
     void cleanup(VkDevice device){
-        vkDeviceWaitIdle(device);
-
         vkDestroyBuffer(device, buffer, nullptr);
         vkFreeMemory(device, memory, nullptr);
     }
@@ -58,10 +85,9 @@ struct ImageData{
     //Stores an image view for the texture
     std::vector<VkImageView> imageViews;
 
-    /// @brief Cleans up the view, memory and image buffers
+    /// @brief Cleans up the view, memory and image buffers. The GPU must have finished with them; use VulkanRenderer::retireImage otherwise
     /// @param device The logical device the image exists on
     void cleanup(VkDevice device){
-        vkDeviceWaitIdle(device);
         for(auto view : imageViews)
             vkDestroyImageView(device, view, nullptr);
         vkDestroyImage(device, image, nullptr);
@@ -71,6 +97,48 @@ struct ImageData{
     }
 };
 
+//Monotonically increasing count of the work submitted to a queue; each submission signals the next value
+//Backed by a timeline semaphore when the device supports them, otherwise by a fence per submission
+struct QueueTimeline{
+    //Timeline semaphore signaled with each submission's value. Null when fences are used
+    VkSemaphore semaphore = VK_NULL_HANDLE;
+    //Value signaled by the most recent submission
+    std::atomic<uint64_t> submittedValue{0};
+    //Highest value known to have completed. Guarded by mutex
+    uint64_t completedValue = 0;
+    //Fences of submissions not yet known to be complete with their values, oldest first. Only used without timeline semaphores
+    std::deque<std::pair<uint64_t, VkFence>> pendingFences;
+    //Completed fences, reset for reuse. Only used without timeline semaphores
+    std::vector<VkFence> freeFences;
+    //Guards the completed value and fence lists; uploads on the main thread and frames on the render thread share timelines
+    std::mutex mutex;
+};
+
+//Vulkan handles released while the GPU may still be using them. Null handles are ignored by the destroy functions
+struct RetiredResource{
+    //Number of frames submitted when the resource was released. Destroyed once the GPU has completed that many frames
+    uint64_t frame = 0;
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkImage image = VK_NULL_HANDLE;
+    std::vector<VkImageView> imageViews;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    std::vector<VkFramebuffer> framebuffers;
+    VkSwapchainKHR swapChain = VK_NULL_HANDLE;
+
+    /// @brief Destroys the handles
+    /// @param device The logical device the handles exist on
+    void destroy(VkDevice device){
+        for(auto framebuffer : framebuffers)
+            vkDestroyFramebuffer(device, framebuffer, nullptr);
+        for(auto view : imageViews)
+            vkDestroyImageView(device, view, nullptr);
+        vkDestroyImage(device, image, nullptr);
+        vkDestroyBuffer(device, buffer, nullptr);
+        vkFreeMemory(device, memory, nullptr);
+        vkDestroySwapchainKHR(device, swapChain, nullptr);
+    }
+};
+
 //Container for a set of Mesh data. Currently Vertex and Index data is split into two device memory allocations
 struct MeshData{
     //Buffer set for mesh vertices
@@ -96,15 +164,92 @@ struct TransformData{
     }
 };
 
-struct CameraData{
-    //Buffer set for camera matrices
-    BufferSet cameraBufferSet;
-
+//Container for one frame in flight's copy of the per-object data
+struct ObjectBufferFrame{
+    //Storage buffer of ObjectGpuData entries indexed by object slot
+    BufferSet objectBufferSet;
+    //Persistent host mapping of the buffer memory
+    void* mapped = nullptr;
+    //Number of slots the buffer holds
+    uint32_t capacity = 0;
+    //Slots written since this copy was last brought up to date
+    std::vector<uint32_t> dirtySlots;
+    //Non-zero for slots already in dirtySlots. Indexed by slot
+    std::vector<uint8_t> isSlotDirty;
+
+    /// @brief Unmaps and releases the buffer
+    /// @param device The logical device the buffer exists on
     void cleanup(VkDevice device){
-        cameraBufferSet.cleanup(device);
+        if(capacity == 0)
+            return;
+
+        vkUnmapMemory(device, objectBufferSet.memory);
+        objectBufferSet.cleanup(device);
+        mapped = nullptr;
+        capacity = 0;
     }
 };
 
-struct PushConstants{
-    alignas(16) glm::mat4 mvp;
+//Per-view uniform data. Matches the std140 layout of ViewData in the vertex shader
+struct ViewGpuData{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    //Normalized frustum planes pointing inwards; xyz is the normal and w the distance
+    glm::vec4 frustumPlanes[6];
+    //World space position of the camera; w is unused
+    glm::vec4 position;
+};
+
+//Persistently mapped, host coherent buffer for data rewritten every frame; eg view uniforms, instance data and indirect commands
+//Split into a partition per frame in flight so a frame never overwrites data the GPU may still be reading from an earlier frame
+struct DynamicRingBuffer{
+    //Buffer set holding every partition
+    BufferSet bufferSet;
+    //Persistent host mapping of the whole buffer
+    void* mapped = nullptr;
+    //Size of each frame's partition in bytes
+    VkDeviceSize partitionSize = 0;
+    //Offset of the current frame's partition from the start of the buffer
+    VkDeviceSize partitionOffset = 0;
+    //Bump pointer; offset of the next free byte from the start of the buffer
+    VkDeviceSize head = 0;
+
+    /// @brief Starts handing out memory from a frame's partition, discarding everything the frame allocated last time. The frame must not be in flight
+    /// @param frame Index of the frame in flight
+    void beginFrame(uint32_t frame){
+        partitionOffset = partitionSize * frame;
+        head = partitionOffset;
+    }
+
+    /// @brief Sub-allocates memory from the current frame's partition
+    /// @param size Size of the allocation in bytes
+    /// @param alignment Required alignment of the offset; eg the device's minimum uniform buffer offset alignment
+    /// @return Returns the offset of the allocation from the start of the buffer
+    VkDeviceSize allocate(VkDeviceSize size, VkDeviceSize alignment){
+        VkDeviceSize offset = (head + alignment - 1) / alignment * alignment;
+        if(offset + size > partitionOffset + partitionSize)
+            throw std::runtime_error("Failed to allocate dynamic buffer memory. The frame's partition of the ring buffer is full");
+
+        head = offset + size;
+        return offset;
+    }
+
+    /// @brief Returns the mapped address of an allocation
+    /// @param offset Offset returned by allocate
+    /// @return
+    void* getMapped(VkDeviceSize offset){
+        return static_cast<char*>(mapped) + offset;
+    }
+
+    /// @brief Unmaps and releases the buffer
+    /// @param device The logical device the buffer exists on
+    void cleanup(VkDevice device){
+        if(mapped == nullptr)
+            return;
+
+        vkUnmapMemory(device, bufferSet.memory);
+        bufferSet.cleanup(device);
+        mapped = nullptr;
+    }
 };
\ No newline at end of file
@@ -9,6 +9,8 @@
 #include <set>
 #include <limits>
 #include <algorithm>
+#include <cctype>
+#include <iterator>
 #include <glm/glm.hpp>
 
 #include "mesh.h"
@@ -20,6 +22,7 @@
 #include "util_io.h"
 #include "structs_model.h"
 #include "rendererData.h"
+#include "culling.h"
 
 void VulkanRenderer::initialize(GLFWwindow* a_window, int a_width, int a_height, std::reference_wrapper<Event<int,int>> a_windowResizeEventRef){
     windowResizedEvent = a_windowResizeEventRef;
@@ -30,49 +33,71 @@ void VulkanRenderer::initialize(GLFWwindow* a_window, int a_width, int a_height,
     initVulkan(a_window);
 }
 
-bool VulkanRenderer::render(Camera* camera, std::vector<Object*> objects){
-    //Wait for the presentation fence for the frame to complete
-    //vkWaitForFences(device, 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
-    vkWaitForFences(device, 1, &renderFence, VK_TRUE, UINT64_MAX);
+bool VulkanRenderer::render(const FrameSnapshot& snapshot){
+    //Object writes are kept even for frames that aren't drawn, as the main thread won't send them again once this snapshot is acknowledged
+    applyObjectUpdates(snapshot);
+    //Free resources unloaded since the frames using them have completed
+    destroyRetiredResources();
+
+    //Nothing to draw to
+    if(snapshot.views.empty())
+        return true;
+
+    //Skip rendering while the window is minimized. Any pending resize is kept until the window has a size again
+    if(width.load() == 0 || height.load() == 0)
+        return true;
+
+    //Recreate the swap chain on this thread if the window was resized or the surface went out of date since the last frame
+    //Any number of resizes between frames result in a single recreation. Retry next frame if the surface has no area yet
+    if(swapChainResized.exchange(false) && !recreateSwapChain()){
+        swapChainResized = true;
+        return true;
+    }
+
+    //Wait for the previous frame's last batch to complete. Uploads submitted since then aren't waited on
+    waitTimeline(graphicsTimeline, lastFrameTimelineValue);
     
-    //TODO: This call could, and likely should, be moved to a thread and managed that way to prevent the blocking call from locking the main thread. Not an issue with simple triangles but complex models or scenes will cause problems
     //Fetch an image from the swap chain when it is done presentation
-    //Blocking call; will wait until image is received or timeout is reached
+    //Blocking call; runs on the render thread so the main thread keeps simulating the next frame
     uint32_t imageIndex;
     VkResult result = vkAcquireNextImageKHR(device, swapChain, UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
 
-    //If the results of attempting to acquire the next swap chain image fails due to the swap chain being out of date, regenerate the chain
+    //If the results of attempting to acquire the next swap chain image fails due to the swap chain being out of date, regenerate the chain at the start of the next frame
     if(result == VK_ERROR_OUT_OF_DATE_KHR){
-        recreateSwapChain();
+        swapChainResized = true;
         return false;
     } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
         throw std::runtime_error("Failed to acquire swap chain image");
 
-    //Get camera's view and projection matrices and premultiply them
-    glm::mat4 viewProj = camera->getPerspectiveMatrix() * camera->getViewMatrix();
+    //Write the slots changed since this frame's copy of the object buffer was last used
+    flushObjectBuffer(currentFrame);
+    //The frame's previous use of its ring partition has completed; reuse it for this frame's dynamic data
+    dynamicRing.beginFrame(currentFrame);
+    //Write the uniforms of the views; the draws select the primary view's entry with a dynamic offset
+    writeViewData(snapshot.views);
+
+    size_t drawCount = snapshot.draws.size();
+    //Always submit at least one batch so the image is cleared and the render finished semaphore is signaled
+    size_t batchCount = drawCount == 0 ? 1 : (drawCount + MAX_OBJECT_DESCRIPTOR_SETS - 1) / MAX_OBJECT_DESCRIPTOR_SETS;
+    size_t submittedBatches = 0;
 
-    size_t arrSize = objects.size();
-    Object* pObjectSubset;
     std::vector<VkWriteDescriptorSet> descriptorWrites;
     VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
     VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
-    for(int i = 0; i < arrSize; i += MAX_OBJECT_DESCRIPTOR_SETS){
-        //Reset the batch render fence
-        vkResetFences(device, 1, &renderFence);
-
+    //Only the primary view is drawn. Every view would clear and fill the whole image, wiping the views before it, until views can be composited
+    uint32_t primaryViewOffset = viewDataOffsets[0];
+    for(size_t batch = 0; batch < batchCount; batch++){
         //Clear the list of descriptor writes of any previous entries
         descriptorWrites.clear();
 
-        //Get object subset array using array pointer
-        pObjectSubset = objects[i];
-
-        //Determine remaining number of objects to account for final set when not a multiple of MAX_OBJECT_DECRIPTOR_SETS
-        int objectCount = arrSize - i;
-        objectCount = objectCount >= MAX_OBJECT_DESCRIPTOR_SETS ? MAX_OBJECT_DESCRIPTOR_SETS : objectCount;
+        //Determine remaining number of draws to account for final set when not a multiple of MAX_OBJECT_DECRIPTOR_SETS
+        size_t first = batch * MAX_OBJECT_DESCRIPTOR_SETS;
+        int batchDrawCount = static_cast<int>(std::min<size_t>(drawCount - std::min(first, drawCount), MAX_OBJECT_DESCRIPTOR_SETS));
+        const SnapshotDraw* pDrawSubset = snapshot.draws.data() + first;
 
         //Generate Descriptor Set updates
-        for(int idx = 0; idx < objectCount; idx++)
-            updateDescriptorSet(descriptorWrites, objectDescriptorSets[idx], pObjectSubset + idx);
+        for(int idx = 0; idx < batchDrawCount; idx++)
+            updateDescriptorSet(descriptorWrites, objectDescriptorSets[idx], pDrawSubset[idx].material);
 
         //Apply the updates
         vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
@@ -82,14 +107,18 @@ bool VulkanRenderer::render(Camera* camera, std::vector<Object*> objects){
         vkResetCommandBuffer(graphicsCommandBuffers[currentFrame], 0);
 
         //Record command buffer
-        recordObjectRenderCommandBuffer(graphicsCommandBuffers[currentFrame], imageIndex, viewProj, pObjectSubset, objectCount);
+        recordObjectRenderCommandBuffer(graphicsCommandBuffers[currentFrame], imageIndex, primaryViewOffset, pDrawSubset, batchDrawCount, snapshot.ranges.data());
+
+        //Only the first batch waits on the image and only the last batch signals presentation
+        bool firstBatch = submittedBatches == 0;
+        bool lastBatch = ++submittedBatches == batchCount;
 
         //Generate the queue submition info
         VkSubmitInfo submitInfo{};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
         VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-        submitInfo.waitSemaphoreCount = 1;
+        submitInfo.waitSemaphoreCount = firstBatch ? 1 : 0;
         //Specify which sempahores to wait on before execution begins
         submitInfo.pWaitSemaphores = waitSemaphores;
         //Specify which stages of the pipeline to wait
@@ -98,19 +127,22 @@ bool VulkanRenderer::render(Camera* camera, std::vector<Object*> objects){
         submitInfo.commandBufferCount =1;
         submitInfo.pCommandBuffers = &graphicsCommandBuffers[currentFrame];
         //Specify which semaphores to signal once command buffers have finished execution
-        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.signalSemaphoreCount = lastBatch ? 1 : 0;
         submitInfo.pSignalSemaphores = signalSemaphores;
 
-        //Submit the render buffer to queue and indicate a fence to be signaled when the buffers finish execution
-        if(vkQueueSubmit(graphicsQueue, 1, &submitInfo, renderFence) != VK_SUCCESS){
-            throw std::runtime_error("Failed to submit draw command buffer");
-            return false;
-        }
+        //Submit the render buffer to queue; the batch signals the next graphics timeline value when the buffers finish execution
+        uint64_t batchValue = submitToTimeline(graphicsTimeline, graphicsQueue, submitInfo);
 
-        //Wait for Fence to indicate renders are done
-        vkWaitForFences(device, 1, &renderFence, VK_TRUE, UINT64_MAX);
+        //Wait for the batch before its descriptor sets and command buffer are reused. The last batch is waited on at the start of the next frame
+        if(!lastBatch)
+            waitTimeline(graphicsTimeline, batchValue);
+        else
+            lastFrameTimelineValue = batchValue;
     }
 
+    //Resources retired from here on may have been used by this frame
+    submittedFrameCount++;
+
     //Present the frame
     VkPresentInfoKHR presentInfo{};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -125,11 +157,15 @@ bool VulkanRenderer::render(Camera* camera, std::vector<Object*> objects){
     //Allows specification of an array of VkResult valuese to check for if presentation was successful on every individual swap chain
     presentInfo.pResults = nullptr;
 
-    //Queue the presentation of the frame
-    result = vkQueuePresentKHR(presentQueue, &presentInfo);
+    //Queue the presentation of the frame. Presenting can block on the swap chain, so the submission lock is only taken if uploads share the present queue
+    {
+        bool sharesSubmitQueue = presentQueue == graphicsQueue || presentQueue == transferQueue;
+        std::lock_guard<std::mutex> lock(sharesSubmitQueue ? queueSubmitMutex : presentMutex);
+        result = vkQueuePresentKHR(presentQueue, &presentInfo);
+    }
     
     if(result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR){
-        recreateSwapChain();
+        swapChainResized = true;
     }
     else if (result != VK_SUCCESS)
         throw std::runtime_error("Failed to present swap chain image");
@@ -145,30 +181,41 @@ void VulkanRenderer::cleanup(){
     //Wait for the logical device to finish operations before exiting main loop
     vkDeviceWaitIdle(device);
 
+    //Every frame has completed, so anything still waiting to be destroyed can go
+    destroyRetiredResources(true);
+
     //Clean up the swap chain and its dependent objects
     cleanupSwapChain();
 
     //Clean up the texture sampler
     vkDestroySampler(device, textureSampler, nullptr);
 
-    //Clean up the descriptor pool
+    //Clean up the object buffers and the dynamic ring
+    for(auto& frame : objectBufferFrames)
+        frame.cleanup(device);
+    dynamicRing.cleanup(device);
+
+    //Clean up the descriptor pools
     vkDestroyDescriptorPool(device, objectDescriptorPool, nullptr);
+    vkDestroyDescriptorPool(device, frameDescriptorPool, nullptr);
 
-    //Clean up the descriptor set layout
+    //Clean up the descriptor set layouts
     vkDestroyDescriptorSetLayout(device, objectDescriptorSetLayout, nullptr);
+    vkDestroyDescriptorSetLayout(device, frameDescriptorSetLayout, nullptr);
 
     //Clean up sync objects
     for(int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++){
         vkDestroySemaphore(device, imageAvailableSemaphores[i], nullptr);
         vkDestroySemaphore(device, renderFinishedSemaphores[i], nullptr);
-        vkDestroyFence(device, inFlightFences[i], nullptr);
     }
 
-    //Clean up batch object render fence
-    vkDestroyFence(device, renderFence, nullptr);
+    //Clean up the queue timelines
+    destroyTimeline(graphicsTimeline);
+    destroyTimeline(transferTimeline);
 
     //Clean up the command pools
     vkDestroyCommandPool(device, graphicsCommandPool, nullptr);
+    vkDestroyCommandPool(device, graphicsUploadCommandPool, nullptr);
     vkDestroyCommandPool(device, transferCommandPool, nullptr);
 
     //Clean up the graphics pipeline
@@ -212,8 +259,8 @@ void VulkanRenderer::unloadTexture(Texture* image){
 
     //Cast to the Vulkan data container 
     ImageData* imageData = static_cast<ImageData*>(image->pRendererData->rendererData);
-    //Invoke the cleanup method to release the memory
-    imageData->cleanup(device);
+    //Frames still on the GPU may sample the image; it is destroyed once they complete
+    retireImage(*imageData);
 
     //Delete the ImageData instance
     delete imageData;
@@ -235,20 +282,60 @@ void VulkanRenderer::uploadMesh(Mesh* mesh){
 }
 
 void VulkanRenderer::unloadMesh(Mesh* mesh){
-    if(mesh->pRendererData == nullptr)
+    if(mesh->pRendererData->rendererData == nullptr)
         return;
 
     //Cast to the Vulkan data container 
     MeshData* meshData = static_cast<MeshData*>(mesh->pRendererData->rendererData);
     
-    //Invoke the cleanup method to release the Vulkan memory
-    meshData->cleanup(device);
+    //Frames still on the GPU may read the buffers; they are destroyed once those frames complete
+    retireBuffer(meshData->vertexBufferSet);
+    retireBuffer(meshData->indexBufferSet);
 
     //Delete the MeshData instance
     delete meshData;
 
     //Null out the pointer as all data is cleaned
-    mesh->pRendererData = nullptr;
+    mesh->pRendererData->rendererData = nullptr;
+}
+
+void VulkanRenderer::retireResource(RetiredResource resource, uint64_t extraFrames){
+    std::lock_guard<std::mutex> lock(retiredResourceMutex);
+    //Read under the lock so entries are queued in frame order
+    resource.frame = submittedFrameCount.load() + extraFrames;
+
+    //Keep the queue ordered when waiting on further frames
+    auto position = retiredResources.end();
+    while(position != retiredResources.begin() && std::prev(position)->frame > resource.frame)
+        position--;
+    retiredResources.insert(position, std::move(resource));
+}
+
+void VulkanRenderer::retireBuffer(const BufferSet& bufferSet){
+    RetiredResource resource;
+    resource.buffer = bufferSet.buffer;
+    resource.memory = bufferSet.memory;
+    retireResource(std::move(resource));
+}
+
+void VulkanRenderer::retireImage(const ImageData& imageData){
+    RetiredResource resource;
+    resource.image = imageData.image;
+    resource.imageViews = imageData.imageViews;
+    resource.memory = imageData.memory;
+    retireResource(std::move(resource));
+}
+
+void VulkanRenderer::destroyRetiredResources(bool all){
+    //Frames are only submitted from this thread and complete in order, so completion of the last frame's final batch means every submitted frame is done
+    if(isTimelineComplete(graphicsTimeline, lastFrameTimelineValue))
+        completedFrameCount = submittedFrameCount.load();
+
+    std::lock_guard<std::mutex> lock(retiredResourceMutex);
+    while(!retiredResources.empty() && (all || retiredResources.front().frame <= completedFrameCount)){
+        retiredResources.front().destroy(device);
+        retiredResources.pop_front();
+    }
 }
 
 void VulkanRenderer::registerCamera(Camera* camera){
@@ -332,7 +419,14 @@ void VulkanRenderer::createInstance(){
     appInfo.applicationVersion = VK_MAKE_VERSION(0,0,1);
     appInfo.pEngineName = "Lightbring Engine";
     appInfo.engineVersion = VK_MAKE_VERSION(0,1,0);
-    appInfo.apiVersion = VK_API_VERSION_1_0;
+    //Loaders older than 1.1 lack vkEnumerateInstanceVersion and refuse any version but 1.0
+    auto enumerateInstanceVersion = reinterpret_cast<PFN_vkEnumerateInstanceVersion>(vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion"));
+    if(enumerateInstanceVersion != nullptr){
+        uint32_t loaderVersion = VK_API_VERSION_1_0;
+        enumerateInstanceVersion(&loaderVersion);
+        instanceApiVersion = std::min(loaderVersion, static_cast<uint32_t>(VK_API_VERSION_1_2));
+    }
+    appInfo.apiVersion = instanceApiVersion;
 
     //Required structure to inform the Vulkan driver about gloabl extensions and validation layers
     VkInstanceCreateInfo createInfo{};
@@ -381,6 +475,10 @@ void VulkanRenderer::initVulkan(GLFWwindow* window){
     createSurface(window);
     pickPhysicalDevice();
     createLogicalDevice();
+    //Decide where mesh and per-frame buffers are allocated before any are created
+    queryMemoryHeaps();
+    //Every submission signals a queue timeline, including the uploads made while initializing
+    createTimelines();
 
     //Creates the swap chain images, populating the image handles of the ImageData container structures
     createSwapChain();
@@ -388,11 +486,13 @@ void VulkanRenderer::initVulkan(GLFWwindow* window){
     createSwapChainImageViews();
     createRenderPass();
 
-    //Create the descriptor set layout for rendered objects
+    //Create the descriptor set layouts for rendered objects and for the data shared by a frame's draws
     createObjectDescriptorSetLayout();
+    createFrameDescriptorSetLayout();
 
     createGraphicsPipeline();
     createCommandPool(graphicsCommandPool, queueFamilies[0]);
+    createCommandPool(graphicsUploadCommandPool, queueFamilies[0]);
     createCommandPool(transferCommandPool, queueFamilies[1]);
     createDepthResources();
     createFrameBuffers();
@@ -409,6 +509,18 @@ void VulkanRenderer::initVulkan(GLFWwindow* window){
     });
     //Pre-allocate the descriptor sets for objects in the scene
     createDescriptorSets(objectDescriptorPool, static_cast<uint32_t>(MAX_OBJECT_DESCRIPTOR_SETS), std::vector<VkDescriptorSetLayout>{static_cast<size_t>(MAX_OBJECT_DESCRIPTOR_SETS), objectDescriptorSetLayout}, objectDescriptorSets);
+
+    //Create the descriptor pool for per frame descriptor sets
+    createDescriptorPool(frameDescriptorPool, MAX_FRAMES_IN_FLIGHT, std::vector<VkDescriptorPoolSize>{
+        //One object buffer per frame in flight
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT)},
+        //One view uniform binding into the dynamic ring per frame in flight
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+        static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT)}
+    });
+    //Create the object buffers, the dynamic ring and their descriptor sets
+    createFrameDataBuffers();
     
     //createDescriptorSets(cameraDescriptorPool, MAX_CAMERA_DESCRIPTOR_SETS, std::vector<VkDescriptorSetLayout>{MAX_CAMERA_DESCRIPTOR_SETS, cameraDescriptorSetLayout}, cameraDescriptorSets);
 
@@ -526,7 +638,8 @@ void VulkanRenderer::createImageView(ImageData* imageData, VkFormat format, VkIm
 }
 
 void VulkanRenderer::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height){
-    //Create and Begin the command buffer
+    //Create and Begin the command buffer. The one off pools are shared by uploads on the main thread and swap chain recreation on the render thread
+    std::lock_guard<std::mutex> commandLock(singleTimeCommandMutex);
     VkCommandBuffer commandBuffer = beginSingleTimeCommands(transferCommandPool);
 
     VkBufferImageCopy region{};
@@ -589,7 +702,7 @@ void VulkanRenderer::transitionImageLayout(VkImage& image, VkFormat format, VkIm
         destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
 
         //Use the graphics pool as the target layout is for shader usage
-        commandPool = graphicsCommandPool;
+        commandPool = graphicsUploadCommandPool;
         commandQueue = graphicsQueue;
     }
     else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL){
@@ -599,13 +712,14 @@ void VulkanRenderer::transitionImageLayout(VkImage& image, VkFormat format, VkIm
         sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
         destinationStage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
 
-        commandPool = graphicsCommandPool;
+        commandPool = graphicsUploadCommandPool;
         commandQueue = graphicsQueue;
     }
     else
         throw std::invalid_argument("Unsupported layout transition");
 
-    //Create and Begin the command buffer
+    //Create and Begin the command buffer. The one off pools are shared by uploads on the main thread and swap chain recreation on the render thread
+    std::lock_guard<std::mutex> commandLock(singleTimeCommandMutex);
     VkCommandBuffer commandBuffer = beginSingleTimeCommands(commandPool);
 
     VkImageMemoryBarrier barrier{};
@@ -654,13 +768,17 @@ VkCommandBuffer VulkanRenderer::beginSingleTimeCommands(VkCommandPool& commandPo
 
     //Allocate the command buffer in the pool
     VkCommandBuffer commandBuffer;
-    vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
+    if(vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+        throw std::runtime_error("Failed to allocate single time command buffer");
 
     //Populate the command buffer with the Begin command
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    if(vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS){
+        vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+        throw std::runtime_error("Failed to begin single time command buffer");
+    }
 
     //Return the created command buffer
     return commandBuffer;
@@ -676,10 +794,17 @@ void VulkanRenderer::endSingleTimeCommands(VkCommandBuffer commandBuffer, VkQueu
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &commandBuffer;
 
-    //Submit the command to the queue
-    vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-    //Wait for the queue to finish
-    vkQueueWaitIdle(queue);
+    //Submit the command and wait for exactly its timeline value rather than idling the queue, which would also wait on the render thread's work
+    QueueTimeline& timeline = getQueueTimeline(queue);
+    uint64_t value;
+    try{
+        value = submitToTimeline(timeline, queue, submitInfo);
+    } catch(...){
+        //Nothing was submitted, so the buffer can be freed before passing the error on
+        vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+        throw;
+    }
+    waitTimeline(timeline, value);
 
     //Clean up the completed command
     vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
@@ -782,12 +907,11 @@ void VulkanRenderer::createTextureImage(const Texture* texture, ImageData* outpu
     vkFreeMemory(device, stagingBufferMemory, nullptr);
 }
 
-void VulkanRenderer::updateDescriptorSet(std::vector<VkWriteDescriptorSet>& descriptorWrites, VkDescriptorSet& descriptorSet, Object* object){
+void VulkanRenderer::updateDescriptorSet(std::vector<VkWriteDescriptorSet>& descriptorWrites, VkDescriptorSet& descriptorSet, Material* matComp){
     //Create descriptor write for material
-    Component* matComp = object->getComponent(ComponentType::COMP_MATERIAL);
     if(matComp){
         //Albedo
-        ImageData* albedoData = static_cast<ImageData*>(static_cast<Material*>(matComp)->albedo->pRendererData->rendererData);
+        ImageData* albedoData = static_cast<ImageData*>(matComp->albedo->pRendererData->rendererData);
         VkDescriptorImageInfo* imageInfo = new VkDescriptorImageInfo();
         imageInfo->imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
         imageInfo->imageView = albedoData->imageViews[0];
@@ -854,20 +978,27 @@ void VulkanRenderer::createDescriptorPool(VkDescriptorPool& descriptorPool, int
         throw std::runtime_error("Failed to create descriptor pool");
 }
 
-template <typename T>
-BufferSet VulkanRenderer::createUniformBuffer(){
-    VkDeviceSize bufferSize = sizeof(T);
+void VulkanRenderer::createDynamicRing(){
+    dynamicRing.partitionSize = DYNAMIC_RING_PARTITION_SIZE;
 
-    BufferSet output;
+    //Usable for every kind of per-frame data. Host coherent so writes are visible to the GPU without flushes, and device local when the device allows
+    createBuffer(dynamicRing.partitionSize * MAX_FRAMES_IN_FLIGHT,
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        dynamicMemoryProperties,
+        dynamicRing.bufferSet.buffer,
+        dynamicRing.bufferSet.memory);
 
-    createBuffer(bufferSize,
-        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        output.buffer,
-        output.memory);
+    //Kept mapped for the lifetime of the buffer so updates are a plain memcpy
+    if(vkMapMemory(device, dynamicRing.bufferSet.memory, 0, VK_WHOLE_SIZE, 0, &dynamicRing.mapped) != VK_SUCCESS)
+        throw std::runtime_error("Failed to map dynamic ring buffer");
+    dynamicRing.beginFrame(0);
+}
 
-    //vkMapMemory(device, output.buffer, 0, bufferSize, 0, &uniformBuffersMapped[i]);
-    return output;
+template <typename T>
+VkDeviceSize VulkanRenderer::writeDynamic(const T& data, VkDeviceSize alignment){
+    VkDeviceSize offset = dynamicRing.allocate(sizeof(T), alignment);
+    memcpy(dynamicRing.getMapped(offset), &data, sizeof(T));
+    return offset;
 }
 
 void VulkanRenderer::createObjectDescriptorSetLayout(){
@@ -896,34 +1027,313 @@ void VulkanRenderer::createObjectDescriptorSetLayout(){
         throw std::runtime_error("Failed to create descriptor set layout");
 }
 
+void VulkanRenderer::createFrameDescriptorSetLayout(){
+    //Layout binding for the object buffer
+    VkDescriptorSetLayoutBinding objectLayoutBinding{};
+    objectLayoutBinding.binding = 0;
+    objectLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    objectLayoutBinding.descriptorCount = 1;
+    //Model matrices are only read when transforming vertices
+    objectLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    objectLayoutBinding.pImmutableSamplers = nullptr;
+
+    //Layout binding for the view uniforms in the dynamic ring. Dynamic so the set is bound once per view at that view's offset
+    VkDescriptorSetLayoutBinding cameraLayoutBinding{};
+    cameraLayoutBinding.binding = 1;
+    cameraLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    cameraLayoutBinding.descriptorCount = 1;
+    cameraLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    cameraLayoutBinding.pImmutableSamplers = nullptr;
+
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings = {objectLayoutBinding, cameraLayoutBinding};
+    //Generate the layout creation info
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = bindings.size();
+    layoutInfo.pBindings = bindings.data();
+
+    //Create the descriptor layout
+    if(vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &frameDescriptorSetLayout) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create frame descriptor set layout");
+}
+
+void VulkanRenderer::createFrameDataBuffers(){
+    //Sub-allocations from the dynamic ring must be multiples of the device's offset alignments
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    uniformBufferAlignment = std::max<VkDeviceSize>(properties.limits.minUniformBufferOffsetAlignment, 1);
+    storageBufferAlignment = std::max<VkDeviceSize>(properties.limits.minStorageBufferOffsetAlignment, 1);
+
+    createDynamicRing();
+
+    //Allocate a descriptor set per frame in flight
+    createDescriptorSets(frameDescriptorPool, static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT), std::vector<VkDescriptorSetLayout>{static_cast<size_t>(MAX_FRAMES_IN_FLIGHT), frameDescriptorSetLayout}, frameDescriptorSets);
+
+    objectBufferFrames.resize(MAX_FRAMES_IN_FLIGHT);
+    for(uint32_t idx = 0; idx < static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT); idx++){
+        createObjectBuffer(idx, INITIAL_OBJECT_CAPACITY);
+
+        //Every frame's view uniforms live in the dynamic ring. The range covers a single view; the dynamic offset selects which
+        VkDescriptorBufferInfo bufferInfo{};
+        bufferInfo.buffer = dynamicRing.bufferSet.buffer;
+        bufferInfo.offset = 0;
+        bufferInfo.range = sizeof(ViewGpuData);
+        VkWriteDescriptorSet write = createDescriptorWrite(frameDescriptorSets[idx], 1, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1, &bufferInfo);
+        vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+    }
+}
+
+void VulkanRenderer::createObjectBuffer(uint32_t frameIndex, uint32_t capacity){
+    ObjectBufferFrame& frame = objectBufferFrames[frameIndex];
+    frame.cleanup(device);
+
+    //Host visible so slots are written in place through a persistent mapping rather than staged
+    createBuffer(static_cast<VkDeviceSize>(capacity) * sizeof(ObjectGpuData),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        dynamicMemoryProperties,
+        frame.objectBufferSet.buffer,
+        frame.objectBufferSet.memory);
+    vkMapMemory(device, frame.objectBufferSet.memory, 0, VK_WHOLE_SIZE, 0, &frame.mapped);
+    frame.capacity = capacity;
+
+    //Fill the new buffer with every slot received so far
+    size_t copyCount = std::min<size_t>(objectData.size(), capacity);
+    if(copyCount > 0)
+        memcpy(frame.mapped, objectData.data(), copyCount * sizeof(ObjectGpuData));
+
+    //Point the frame's descriptor set at the new buffer
+    VkDescriptorBufferInfo bufferInfo{};
+    bufferInfo.buffer = frame.objectBufferSet.buffer;
+    bufferInfo.offset = 0;
+    bufferInfo.range = VK_WHOLE_SIZE;
+    VkWriteDescriptorSet write = createDescriptorWrite(frameDescriptorSets[frameIndex], 0, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, &bufferInfo);
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+}
+
+void VulkanRenderer::writeViewData(const std::vector<SnapshotView>& views){
+    viewDataOffsets.clear();
+    for(const SnapshotView& view : views){
+        CullingView cullingView = Culling::makeView(view);
+
+        ViewGpuData data;
+        data.view = view.viewMatrix;
+        data.projection = view.projectionMatrix;
+        data.viewProjection = view.viewProjectionMatrix;
+        for(int plane = 0; plane < 6; plane++)
+            data.frustumPlanes[plane] = cullingView.frustum.planes[plane];
+        data.position = glm::vec4(cullingView.position, 1.0f);
+
+        viewDataOffsets.push_back(static_cast<uint32_t>(writeDynamic(data, uniformBufferAlignment)));
+    }
+}
+
+void VulkanRenderer::applyObjectUpdates(const FrameSnapshot& snapshot){
+    if(snapshot.objectCount > objectData.size())
+        objectData.resize(snapshot.objectCount);
+
+    for(const auto& update : snapshot.objectUpdates){
+        if(update.slot >= objectData.size())
+            objectData.resize(static_cast<size_t>(update.slot) + 1);
+        objectData[update.slot] = update.data;
+
+        //Each frame's copy is written the next time that frame is rendered
+        for(auto& frame : objectBufferFrames){
+            if(update.slot >= frame.isSlotDirty.size())
+                frame.isSlotDirty.resize(objectData.size(), 0);
+            if(frame.isSlotDirty[update.slot])
+                continue;
+            frame.isSlotDirty[update.slot] = 1;
+            frame.dirtySlots.push_back(update.slot);
+        }
+    }
+}
+
+void VulkanRenderer::flushObjectBuffer(uint32_t frameIndex){
+    ObjectBufferFrame& frame = objectBufferFrames[frameIndex];
+
+    //Grow to the next power of two past the slot count. The new buffer is filled from objectData, which covers every dirty slot
+    if(objectData.size() > frame.capacity){
+        uint32_t capacity = std::max(frame.capacity, INITIAL_OBJECT_CAPACITY);
+        while(capacity < objectData.size())
+            capacity *= 2;
+        createObjectBuffer(frameIndex, capacity);
+    }
+    else{
+        ObjectGpuData* mapped = static_cast<ObjectGpuData*>(frame.mapped);
+        for(uint32_t slot : frame.dirtySlots)
+            mapped[slot] = objectData[slot];
+    }
+
+    for(uint32_t slot : frame.dirtySlots)
+        frame.isSlotDirty[slot] = 0;
+    frame.dirtySlots.clear();
+}
+
 void VulkanRenderer::createSyncObjects(){
     //Resize the lists
     imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
     renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
 
     //Define semaphore creation info; no further parameters
     VkSemaphoreCreateInfo semaphoreInfo{};
     semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-    //Define fence creation info
-    VkFenceCreateInfo fenceInfo{};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-    //Create the desired number of semaphores and fences
+    //Create the desired number of semaphores. Frame completion is tracked by the graphics timeline
     for(size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++){
         if(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS
-            || vkCreateSemaphore(device, &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS
-            || vkCreateFence(device, &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS)
+            || vkCreateSemaphore(device, &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS)
             throw std::runtime_error("Failed to create semaphores");
     }
+}
+
+void VulkanRenderer::createTimelines(){
+    //Without timeline semaphores each submission is given a fence instead
+    if(!deviceCapabilities.timelineSemaphores)
+        return;
+
+    VkSemaphoreTypeCreateInfo typeInfo{};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &typeInfo;
+
+    if(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &graphicsTimeline.semaphore) != VK_SUCCESS
+        || vkCreateSemaphore(device, &semaphoreInfo, nullptr, &transferTimeline.semaphore) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create timeline semaphores");
+}
+
+void VulkanRenderer::destroyTimeline(QueueTimeline& timeline){
+    vkDestroySemaphore(device, timeline.semaphore, nullptr);
+    timeline.semaphore = VK_NULL_HANDLE;
+
+    for(auto& pending : timeline.pendingFences)
+        vkDestroyFence(device, pending.second, nullptr);
+    for(auto fence : timeline.freeFences)
+        vkDestroyFence(device, fence, nullptr);
+    timeline.pendingFences.clear();
+    timeline.freeFences.clear();
+}
+
+QueueTimeline& VulkanRenderer::getQueueTimeline(VkQueue queue){
+    //Devices without a separate transfer family hand out the graphics queue for transfers. Values must follow the queue's submission order
+    if(queue == transferQueue && transferQueue != graphicsQueue)
+        return transferTimeline;
+    return graphicsTimeline;
+}
+
+uint64_t VulkanRenderer::submitToTimeline(QueueTimeline& timeline, VkQueue queue, const VkSubmitInfo& submitInfo){
+    VkSubmitInfo timelineSubmitInfo = submitInfo;
+
+    //Binary semaphores ignore their signal values but every semaphore needs one once a timeline is signaled
+    std::vector<VkSemaphore> signalSemaphores(submitInfo.pSignalSemaphores, submitInfo.pSignalSemaphores + submitInfo.signalSemaphoreCount);
+    std::vector<uint64_t> signalValues(submitInfo.signalSemaphoreCount, 0);
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+
+    //Values are assigned under the submission lock so they increase in the queue's submission order
+    std::lock_guard<std::mutex> submitLock(queueSubmitMutex);
+    std::lock_guard<std::mutex> timelineLock(timeline.mutex);
+    uint64_t value = timeline.submittedValue.load() + 1;
+
+    VkFence fence = VK_NULL_HANDLE;
+    if(timeline.semaphore != VK_NULL_HANDLE){
+        signalSemaphores.push_back(timeline.semaphore);
+        signalValues.push_back(value);
+        timelineInfo.pNext = submitInfo.pNext;
+        timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+        timelineInfo.pSignalSemaphoreValues = signalValues.data();
+
+        timelineSubmitInfo.pNext = &timelineInfo;
+        timelineSubmitInfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+        timelineSubmitInfo.pSignalSemaphores = signalSemaphores.data();
+    }
+    else{
+        //Reuse a fence from a completed submission where possible
+        if(!timeline.freeFences.empty()){
+            fence = timeline.freeFences.back();
+            timeline.freeFences.pop_back();
+        }
+        else{
+            VkFenceCreateInfo fenceInfo{};
+            fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            if(vkCreateFence(device, &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+                throw std::runtime_error("Failed to create submission fence");
+        }
+    }
+
+    if(vkQueueSubmit(queue, 1, &timelineSubmitInfo, fence) != VK_SUCCESS){
+        if(fence != VK_NULL_HANDLE)
+            timeline.freeFences.push_back(fence);
+        throw std::runtime_error("Failed to submit command buffer");
+    }
+
+    if(fence != VK_NULL_HANDLE)
+        timeline.pendingFences.emplace_back(value, fence);
+    timeline.submittedValue = value;
+
+    return value;
+}
+
+void VulkanRenderer::collectCompletedFences(QueueTimeline& timeline){
+    //Submissions to a queue complete in order, so stop at the first unsignaled fence
+    while(!timeline.pendingFences.empty() && vkGetFenceStatus(device, timeline.pendingFences.front().second) == VK_SUCCESS){
+        timeline.completedValue = std::max(timeline.completedValue, timeline.pendingFences.front().first);
+        vkResetFences(device, 1, &timeline.pendingFences.front().second);
+        timeline.freeFences.push_back(timeline.pendingFences.front().second);
+        timeline.pendingFences.pop_front();
+    }
+}
+
+bool VulkanRenderer::isTimelineComplete(QueueTimeline& timeline, uint64_t value){
+    std::lock_guard<std::mutex> lock(timeline.mutex);
+    if(timeline.completedValue >= value)
+        return true;
+
+    if(timeline.semaphore != VK_NULL_HANDLE){
+        uint64_t currentValue = 0;
+        vkGetSemaphoreCounterValue(device, timeline.semaphore, &currentValue);
+        timeline.completedValue = std::max(timeline.completedValue, currentValue);
+    }
+    else
+        collectCompletedFences(timeline);
+
+    return timeline.completedValue >= value;
+}
+
+void VulkanRenderer::waitTimeline(QueueTimeline& timeline, uint64_t value){
+    if(isTimelineComplete(timeline, value))
+        return;
+
+    if(timeline.semaphore != VK_NULL_HANDLE){
+        VkSemaphoreWaitInfo waitInfo{};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &timeline.semaphore;
+        waitInfo.pValues = &value;
+        vkWaitSemaphores(device, &waitInfo, UINT64_MAX);
+
+        std::lock_guard<std::mutex> lock(timeline.mutex);
+        timeline.completedValue = std::max(timeline.completedValue, value);
+        return;
+    }
 
-    if(vkCreateFence(device, &fenceInfo, nullptr, &renderFence) != VK_SUCCESS)
-        throw std::runtime_error("Failed to create render batch fence");
+    //The lock is held while waiting so the fence can't be recycled by the other thread meanwhile
+    std::lock_guard<std::mutex> lock(timeline.mutex);
+    if(timeline.completedValue >= value)
+        return;
+    for(const auto& pending : timeline.pendingFences){
+        if(pending.first >= value){
+            vkWaitForFences(device, 1, &pending.second, VK_TRUE, UINT64_MAX);
+            break;
+        }
+    }
+    collectCompletedFences(timeline);
 }
 
-void VulkanRenderer::recordObjectRenderCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, glm::mat4 viewProjMatrix, Object* objects, int objectCount){
+void VulkanRenderer::recordObjectRenderCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t viewDataOffset, const SnapshotDraw* draws, int drawCount, const SnapshotRange* ranges){
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     //Defines out the command buffer is to be used
@@ -981,11 +1391,14 @@ void VulkanRenderer::recordObjectRenderCommandBuffer(VkCommandBuffer commandBuff
     //Set the scissor
     vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
+    //Bind the frame's object buffer and this view's uniforms once for every draw. The shader combines them per vertex
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frameDescriptorSets[currentFrame], 1, &viewDataOffset);
+
     Mesh* meshComp;
     MeshData* meshData;
-    for(int idx = 0; idx < objectCount; idx++){
+    for(int idx = 0; idx < drawCount; idx++){
         //Fetch and cast the mesh components and renderer data
-        meshComp = static_cast<Mesh*>(objects->getComponent(ComponentType::COMP_MESH));
+        meshComp = draws[idx].mesh;
         meshData = static_cast<MeshData*>(meshComp->pRendererData->rendererData);
 
         //Bind the vertex buffer to the shader bindings
@@ -993,31 +1406,30 @@ void VulkanRenderer::recordObjectRenderCommandBuffer(VkCommandBuffer commandBuff
         VkDeviceSize offsets[] = {0};
         vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
 
-        //Bind the index buffer to the shader bindings
-        vkCmdBindIndexBuffer(commandBuffer, meshData->indexBufferSet.buffer, 0, VK_INDEX_TYPE_UINT16);
+        //Bind the index buffer to the shader bindings using the width the mesh stores its indices at
+        VkIndexType indexType = meshComp->getIndexType() == IndexType::INDEX_TYPE_UINT32 ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16;
+        vkCmdBindIndexBuffer(commandBuffer, meshData->indexBufferSet.buffer, 0, indexType);
 
-        //Bind the descriptor set for the frame
+        //Bind the descriptor set for the draw's material
         vkCmdBindDescriptorSets(commandBuffer, 
             VK_PIPELINE_BIND_POINT_GRAPHICS, // _GRAPHICS or _COMPUTE
             pipelineLayout, //Layout the descriptors are based on
-            0, //Index of first set
+            1, //Index of first set
             1, //Number of sets to bind
             &objectDescriptorSets[idx], //Array of sets to bind
             0, //Array of offsets
             nullptr); //Pointer to array of offsets
-        
-        //Update the push constants
-        pushConstants.mvp = viewProjMatrix * objects->transform->getTransformMatrix();
-        vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstants), &pushConstants);
-
-        uint32_t indexCount = static_cast<uint32_t>(meshComp->indices.size());
-        //Draw 
-        vkCmdDrawIndexed(commandBuffer, 
-        indexCount, //Index count
-        1, //Instance count for instanced rendering
-        0, //Vertex buffer offset; defines lowest value of gl_VertexIndex
-        0, //Index buffer offset
-        0);//Instance offset for instanced rendering; defines lowest value of gl_InstanceIndex
+
+        //Draw each range of the index buffer that survived culling
+        const SnapshotRange* drawRanges = ranges + draws[idx].rangeOffset;
+        for(uint32_t rangeIdx = 0; rangeIdx < draws[idx].rangeCount; rangeIdx++){
+            vkCmdDrawIndexed(commandBuffer, 
+            drawRanges[rangeIdx].indexCount, //Index count
+            1, //Instance count for instanced rendering
+            drawRanges[rangeIdx].firstIndex, //First index within the index buffer
+            0, //Vertex offset added to each index
+            draws[idx].objectIndex);//Instance offset; gl_InstanceIndex starts here, so the shader uses it to index the object buffer
+        }
     }
     //End the render pass
     vkCmdEndRenderPass(commandBuffer);
@@ -1238,8 +1650,8 @@ void VulkanRenderer::createGraphicsPipeline(){
     dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
     dynamicState.pDynamicStates = dynamicStates.data();
 
-    auto bindingDescription = VkVertex::getBindingDescription();
-    auto attributeDescriptions = VkVertex::getAttributeDescriptions();
+    auto bindingDescription = VkVertexLayout<PackedVertexLayout>::getBindingDescription();
+    auto attributeDescriptions = VkVertexLayout<PackedVertexLayout>::getAttributeDescriptions();
 
     //Informs the graphics pipeline the format of the vertex data that is passed to the vertex shader
     VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
@@ -1364,19 +1776,16 @@ void VulkanRenderer::createGraphicsPipeline(){
     depthStencil.front = {};
     depthStencil.back = {};
 
-    VkPushConstantRange pushConstantRange = {};
-    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-    pushConstantRange.offset = 0;
-    pushConstantRange.size = sizeof(PushConstants);
-
     //Used to specify global uniform values in shaders
     VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    //Set the descriptor set count and address
-    pipelineLayoutInfo.setLayoutCount = 1;
-    pipelineLayoutInfo.pSetLayouts = &objectDescriptorSetLayout;
-    pipelineLayoutInfo.pushConstantRangeCount = 1;
-    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    //Set the descriptor set count and address. Set 0 holds the frame's data and set 1 the draw's material
+    std::array<VkDescriptorSetLayout, 2> setLayouts = {frameDescriptorSetLayout, objectDescriptorSetLayout};
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+    //View data is read from the view uniforms so no push constants are used
+    pipelineLayoutInfo.pushConstantRangeCount = 0;
+    pipelineLayoutInfo.pPushConstantRanges = nullptr;
 
     if(vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
         throw std::runtime_error("Failed to create pipeline layout");
@@ -1437,14 +1846,38 @@ void VulkanRenderer::cleanupSwapChain(){
     swapChainImageData.clear();
 }
 
-void VulkanRenderer::recreateSwapChain(){
-    //Ensure any commands using the device and swap chain are completed before manipulating the swap chain
-    vkDeviceWaitIdle(device);
+void VulkanRenderer::retireSwapChain(){
+    //Frames still in flight render to the frame buffers and depth buffer
+    RetiredResource resource;
+    resource.framebuffers = swapChainFramebuffers;
+    resource.image = depthImage.image;
+    resource.imageViews = depthImage.imageViews;
+    resource.memory = depthImage.memory;
+    for(const auto& swapChainImage : swapChainImageData)
+        resource.imageViews.insert(resource.imageViews.end(), swapChainImage.imageViews.begin(), swapChainImage.imageViews.end());
+    retireResource(std::move(resource));
+
+    //Presentation of the last frame may still be reading the swap chain images after its commands complete
+    RetiredResource swapChainResource;
+    swapChainResource.swapChain = swapChain;
+    retireResource(std::move(swapChainResource), 1);
+
+    swapChainFramebuffers.clear();
+    depthImage.imageViews.clear();
+    swapChainImageData.clear();
+}
 
-    //Clean up the existing swap chain
-    cleanupSwapChain();
+bool VulkanRenderer::recreateSwapChain(){
+    //A minimized window has no area to present to
+    VkSurfaceCapabilitiesKHR capabilities;
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &capabilities);
+    if(capabilities.currentExtent.width == 0 || capabilities.currentExtent.height == 0)
+        return false;
 
-    //Regenerate the swap chain
+    //Retire rather than destroy the existing swap chain so frames in flight finish without idling the device
+    retireSwapChain();
+
+    //Regenerate the swap chain, handing over the old one so the driver can reuse its resources
     createSwapChain();
     //Regenerate the views of the swap chain images
     createSwapChainImageViews();
@@ -1452,6 +1885,8 @@ void VulkanRenderer::recreateSwapChain(){
     createDepthResources();
     //Regenerate the buffers for the swap chain images
     createFrameBuffers();
+
+    return true;
 }
 
 void VulkanRenderer::createSwapChain(){
@@ -1521,9 +1956,8 @@ void VulkanRenderer::createSwapChain(){
     createInfo.presentMode = presentMode;
     //Ignores colors of pixels that are obscured, such as when another window is in front. Enabling this is more performant
     createInfo.clipped = VK_TRUE;
-    //Old swap chain assigned to null. Currently resizing the window isn't supported
-    //This would hold the reference to the old swap chain when creating the new one for the newly resized window
-    createInfo.oldSwapchain = VK_NULL_HANDLE;
+    //The swap chain being replaced when recreating, otherwise null. It is retired rather than destroyed, so it stays valid here
+    createInfo.oldSwapchain = swapChain;
 
     if(vkCreateSwapchainKHR(device, &createInfo, nullptr, &swapChain) != VK_SUCCESS)
         throw std::runtime_error("Failed to create swap chain");
@@ -1599,6 +2033,13 @@ void VulkanRenderer::createLogicalDevice(){
     //Set the features data
     createInfo.pEnabledFeatures = &deviceFeatures;
 
+    //Enable timeline semaphores for queue synchronization when the device supports them
+    VkPhysicalDeviceVulkan12Features features12{};
+    features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    features12.timelineSemaphore = VK_TRUE;
+    if(deviceCapabilities.timelineSemaphores)
+        createInfo.pNext = &features12;
+
     //Set extension information
     createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
     createInfo.ppEnabledExtensionNames = deviceExtensions.data();
@@ -1666,95 +2107,110 @@ void VulkanRenderer::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, V
     vkBindBufferMemory(device, buffer, bufferMemory, 0);
 }
 
-void VulkanRenderer::createVertexBuffer(const Mesh* meshData, MeshData* output){
-    //Determine the size of the buffer
-    VkDeviceSize bufferSize = sizeof(meshData->vertices[0]) * meshData->vertices.size();
+void VulkanRenderer::queryMemoryHeaps(){
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+
+    //Discrete cards without resizable BAR only expose a small host visible window of device memory. It suits per-frame buffers but not meshes
+    VkMemoryPropertyFlags directFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    for(uint32_t i = 0; i < memProperties.memoryTypeCount; i++){
+        if((memProperties.memoryTypes[i].propertyFlags & directFlags) != directFlags)
+            continue;
+
+        hasHostVisibleDeviceMemory = true;
+        if(memProperties.memoryHeaps[memProperties.memoryTypes[i].heapIndex].size >= deviceCapabilities.deviceLocalMemory)
+            hasUnifiedMemory = true;
+    }
+
+    if(hasHostVisibleDeviceMemory)
+        dynamicMemoryProperties = directFlags;
+
+    #ifdef DEBUG_LOG_MEMORY
+    std::cout << "Host visible device memory: " << hasHostVisibleDeviceMemory << ", unified memory: " << hasUnifiedMemory << std::endl;
+    #endif
+}
+
+void VulkanRenderer::createDeviceBuffer(VkDeviceSize size, VkBufferUsageFlags usage, const std::function<void(void*)>& writeData, BufferSet& output){
+    void* data;
+
+    //The device's own memory is host visible; write straight into it and skip the staging copy
+    if(hasUnifiedMemory){
+        createBuffer(size,
+            usage,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            output.buffer,
+            output.memory);
+
+        vkMapMemory(device, output.memory, 0, size, 0, &data);
+        writeData(data);
+        vkUnmapMemory(device, output.memory);
+        return;
+    }
 
     VkBuffer stagingBuffer;
     VkDeviceMemory stagingBufferMemory;
-    //Create a buffer for the vertex data to staged in
-    createBuffer(bufferSize, 
+    //Create a buffer for the data to be staged in
+    createBuffer(size, 
         VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 
         stagingBuffer,
         stagingBufferMemory);
 
-    void* data;
     //Map the buffer memory into CPU accessible memory
-    vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-    //Copy the vertex data into the buffer
-    memcpy(data, meshData->vertices.data(), (size_t) bufferSize);
+    vkMapMemory(device, stagingBufferMemory, 0, size, 0, &data);
+    writeData(data);
     //Unmap the memory as we no longer need access
     vkUnmapMemory(device, stagingBufferMemory);
 
-    #ifdef DEBUG_LOG_VERTICES
-    std::cout << "Vertex Data:" << std::endl;
-    for(int idx = 0; idx < meshData->vertices.size(); idx++){
-        std::cout << "V" << idx <<": " << meshData->vertices[idx].pos.x << ", " << meshData->vertices[idx].pos.y << ", " << meshData->vertices[idx].pos.z << std::endl;
-    }
-    #endif
-
-    //Create the buffer for the vertex data to exist locally on the device
-    createBuffer(bufferSize, 
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, 
+    //Create the buffer for the data to exist locally on the device
+    createBuffer(size, 
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage, 
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        output->vertexBufferSet.buffer,
-        output->vertexBufferSet.memory);
+        output.buffer,
+        output.memory);
 
-    //Copy the staging buffer into the vertex buffer
-    copyBuffer(stagingBuffer, output->vertexBufferSet.buffer, bufferSize);
+    //Copy the staging buffer into the device buffer
+    copyBuffer(stagingBuffer, output.buffer, size);
 
     //Clean up the staging buffer and its memory
     vkDestroyBuffer(device, stagingBuffer, nullptr);
     vkFreeMemory(device, stagingBufferMemory, nullptr);
 }
 
-void VulkanRenderer::createIndexBuffer(const Mesh* meshData, MeshData* output){
-    //Determine the size of the buffer
-    VkDeviceSize bufferSize = sizeof(meshData->indices[0]) * meshData->indices.size();
-
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-
-    //Create the staging buffer
-    createBuffer(bufferSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        stagingBuffer,
-        stagingBufferMemory);
+void VulkanRenderer::createVertexBuffer(const Mesh* meshData, MeshData* output){
+    #ifdef DEBUG_LOG_VERTICES
+    std::cout << "Vertex Data:" << std::endl;
+    for(size_t idx = 0; idx < meshData->vertices.size(); idx++){
+        std::cout << "V" << idx <<": " << meshData->vertices[idx].position.x << ", " << meshData->vertices[idx].position.y << ", " << meshData->vertices[idx].position.z << std::endl;
+    }
+    #endif
 
-    void* data;
-    //Map the memory of the staging buffer to the void pointer
-    vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-    //Copy the data into the buffer the pointer indicates
-    memcpy(data, meshData->indices.data(), (size_t) bufferSize);
-    //Unmap the staging buffer
-    vkUnmapMemory(device, stagingBufferMemory);
+    //Write the packed vertices into the buffer. Cooked meshes are copied straight from the mapped file
+    createDeviceBuffer(meshData->getVertexDataSize(),
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        [meshData](void* data) { meshData->writeVertexData(data); },
+        output->vertexBufferSet);
+}
 
+void VulkanRenderer::createIndexBuffer(const Mesh* meshData, MeshData* output){
     #ifdef DEBUG_LOG_INDICES
     std::cout << "Index Data:" << std::endl;
-    for(int idx = 0; idx < meshData->indices.size(); idx++){
-        std::cout << "I" << idx << ": " << meshData->indices[idx] << std::endl;
+    for(uint32_t idx = 0; idx < meshData->getIndexCount(); idx++){
+        std::cout << "I" << idx << ": " << meshData->getIndex(idx) << std::endl;
     }
     #endif
 
-    //Create the destination buffer on the device
-    createBuffer(bufferSize, 
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        output->indexBufferSet.buffer,
-        output->indexBufferSet.memory);
-    
-    //Copy the memory from source to destination
-    copyBuffer(stagingBuffer, output->indexBufferSet.buffer, bufferSize);
-
-    //Clean up the staging buffer and its memory
-    vkDestroyBuffer(device, stagingBuffer, nullptr);
-    vkFreeMemory(device, stagingBufferMemory, nullptr);
+    //Copy the indices in the width the mesh stores them at
+    VkDeviceSize bufferSize = meshData->getIndexDataSize();
+    createDeviceBuffer(bufferSize,
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+        [meshData, bufferSize](void* data) { memcpy(data, meshData->getIndexData(), static_cast<size_t>(bufferSize)); },
+        output->indexBufferSet);
 }
 
 void VulkanRenderer::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size){
-    //Create the command buffer
+    //Create the command buffer. The one off pools are shared by uploads on the main thread and swap chain recreation on the render thread
+    std::lock_guard<std::mutex> commandLock(singleTimeCommandMutex);
     VkCommandBuffer commandBuffer = beginSingleTimeCommands(transferCommandPool);
 
     //Populate the command buffer with a CopyBuffer command
@@ -1939,6 +2395,102 @@ bool VulkanRenderer::isDeviceSuitable(VkPhysicalDevice device){
     //    && deviceFeatures.geometryShader;
 }
     
+DeviceCapabilities VulkanRenderer::queryDeviceCapabilities(VkPhysicalDevice device){
+    DeviceCapabilities capabilities;
+
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(device, &deviceProperties);
+    capabilities.name = deviceProperties.deviceName;
+    capabilities.deviceType = deviceProperties.deviceType;
+    capabilities.apiVersion = deviceProperties.apiVersion;
+
+    VkPhysicalDeviceFeatures deviceFeatures;
+    vkGetPhysicalDeviceFeatures(device, &deviceFeatures);
+    capabilities.textureCompressionBC = deviceFeatures.textureCompressionBC;
+
+    //The 1.2 feature structure can only be queried when both the instance and the device support 1.2
+    if(instanceApiVersion >= VK_API_VERSION_1_2 && deviceProperties.apiVersion >= VK_API_VERSION_1_2){
+        VkPhysicalDeviceVulkan12Features features12{};
+        features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+        VkPhysicalDeviceFeatures2 features2{};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &features12;
+        vkGetPhysicalDeviceFeatures2(device, &features2);
+
+        capabilities.descriptorIndexing = features12.descriptorIndexing;
+        capabilities.timelineSemaphores = features12.timelineSemaphore;
+    }
+
+    //The largest device local heap is the device's own memory; shared system memory on integrated GPUs
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(device, &memProperties);
+    for(uint32_t i = 0; i < memProperties.memoryHeapCount; i++)
+        if(memProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+            capabilities.deviceLocalMemory = std::max(capabilities.deviceLocalMemory, memProperties.memoryHeaps[i].size);
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilyProperties.data());
+    for(const auto& queueFamily : queueFamilyProperties){
+        if(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+            continue;
+        if(queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT)
+            capabilities.dedicatedTransferQueue = true;
+        if(queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT)
+            capabilities.dedicatedComputeQueue = true;
+    }
+
+    return capabilities;
+}
+
+uint64_t VulkanRenderer::scoreDevice(const DeviceCapabilities& capabilities){
+    //Features and memory add at most MAX_BONUS, so spacing the type ranks further apart than that keeps type dominant for every tier
+    constexpr uint64_t FEATURE_POINTS = 1000;
+    constexpr uint64_t MAX_MEMORY_POINTS = 4096;
+    constexpr uint64_t MAX_BONUS = 5 * FEATURE_POINTS + MAX_MEMORY_POINTS;
+    constexpr uint64_t TYPE_STEP = MAX_BONUS + 1;
+
+    uint64_t typeRank;
+    switch(capabilities.deviceType){
+        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+            typeRank = 4;
+            break;
+        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+            typeRank = 3;
+            break;
+        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+            typeRank = 2;
+            break;
+        case VK_PHYSICAL_DEVICE_TYPE_CPU:
+            typeRank = 0;
+            break;
+        default:
+            typeRank = 1;
+            break;
+    }
+    uint64_t score = typeRank * TYPE_STEP;
+
+    //Each feature that enables a fast path
+    const bool features[] = {
+        capabilities.descriptorIndexing,
+        capabilities.timelineSemaphores,
+        capabilities.textureCompressionBC,
+        capabilities.dedicatedTransferQueue,
+        capabilities.dedicatedComputeQueue
+    };
+    static_assert(sizeof(features) / sizeof(features[0]) * FEATURE_POINTS + MAX_MEMORY_POINTS == MAX_BONUS, "MAX_BONUS must cover every feature");
+    for(bool feature : features)
+        if(feature)
+            score += FEATURE_POINTS;
+
+    //A point per 64MiB of device memory, capped at 256GiB
+    score += std::min<uint64_t>(capabilities.deviceLocalMemory / (64ull * 1024 * 1024), MAX_MEMORY_POINTS);
+
+    return score;
+}
+
 void VulkanRenderer::pickPhysicalDevice(){
     uint32_t deviceCount = 0;
     //Populates deviceCount with the number of devices available
@@ -1952,11 +2504,42 @@ void VulkanRenderer::pickPhysicalDevice(){
     //Populate the vector with the physical device data structures
     vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
 
-    //Iterate through the detected devices and attempt to find the first compatible device
-    for(const auto& device : devices){
-        if(isDeviceSuitable(device)){
-            physicalDevice = device;
-            break;
+    //Lower case copy of the preferred name for case insensitive matching
+    std::string preferredName = preferredDeviceName;
+    std::transform(preferredName.begin(), preferredName.end(), preferredName.begin(), [](unsigned char c) { return std::tolower(c); });
+    bool hasPreference = preferredDeviceIndex.has_value() || !preferredName.empty();
+
+    //Keep the highest scoring suitable device. Once a preferred device is found only other preferred devices can replace it
+    uint64_t bestScore = 0;
+    bool preferredFound = false;
+    for(uint32_t idx = 0; idx < deviceCount; idx++){
+        if(!isDeviceSuitable(devices[idx]))
+            continue;
+
+        DeviceCapabilities capabilities = queryDeviceCapabilities(devices[idx]);
+        uint64_t score = scoreDevice(capabilities);
+
+        bool isPreferred;
+        if(preferredDeviceIndex.has_value())
+            isPreferred = preferredDeviceIndex.value() == idx;
+        else{
+            std::string name = capabilities.name;
+            std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+            isPreferred = !preferredName.empty() && name.find(preferredName) != std::string::npos;
+        }
+
+        #ifdef DEBUG_LOG_DEVICES
+        std::cout << "Device " << idx << ": " << capabilities.name << ", score " << score << (isPreferred ? ", preferred" : "") << std::endl;
+        #endif
+
+        if(preferredFound && !isPreferred)
+            continue;
+
+        if((isPreferred && !preferredFound) || physicalDevice == VK_NULL_HANDLE || score > bestScore){
+            physicalDevice = devices[idx];
+            deviceCapabilities = capabilities;
+            bestScore = score;
+            preferredFound = preferredFound || isPreferred;
         }
     }
 
@@ -1964,6 +2547,12 @@ void VulkanRenderer::pickPhysicalDevice(){
     if (physicalDevice == VK_NULL_HANDLE){
         throw std::runtime_error("Failed to find a suitable GPU");
     }
+
+    if(hasPreference && !preferredFound)
+        std::cerr << "Preferred device not found or not suitable, using " << deviceCapabilities.name << std::endl;
+
+    //Suitability checks overwrite the queue families with those of the last device checked
+    requestQueueFamilies(physicalDevice);
 }
 
 bool VulkanRenderer::requestQueueFamilies(VkPhysicalDevice physicalDevice){
@@ -1979,22 +2568,16 @@ bool VulkanRenderer::requestQueueFamilies(VkPhysicalDevice physicalDevice){
     queueFamilies.push_back(indices);
 
     //Find a TRANSFER queue family that does not include the GRAPHICS flag and does not support presentation
-    if(!findQueueFamilies(physicalDevice, VK_QUEUE_TRANSFER_BIT, false, &indices, VK_QUEUE_GRAPHICS_BIT))
-        return false;
+    //Graphics families always support transfers, so devices without a separate family upload on the graphics family
+    if(!findQueueFamilies(physicalDevice, VK_QUEUE_TRANSFER_BIT, false, &indices, VK_QUEUE_GRAPHICS_BIT)){
+        indices.reset();
+        indices.queueFamily = queueFamilies[0].queueFamily;
+    }
     queueFamilies.push_back(indices);
 
     return true;
 }
 
-template<typename T>
-void VulkanRenderer::updateBuffer(BufferSet& bufferSet, uint32_t offset, T dataObject){
-    size_t dataSize = sizeof(dataObject);
-    void* data;
-    vkMapMemory(device, bufferSet.memory, offset, dataSize, 0, data);
-    memcpy(data, &dataObject, dataSize);
-    vkUnmapMemory(device, bufferSet.memory);
-}
-
 void VulkanRenderer::populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo){
     //Create a default structure instance
     createInfo = {};
@@ -2045,6 +2628,6 @@ void VulkanRenderer::windowResizedCallback(int a_width, int a_height){
     width = a_width;
     height = a_height;
 
-    //Recreate the swap chain
-    recreateSwapChain();
+    //Invoked on the main thread; the render thread recreates the swap chain before its next frame
+    swapChainResized = true;
 }
\ No newline at end of file
@@ -3,18 +3,23 @@
     #define GLFW_INCLUDE_VULKAN
 #endif
 #include <GLFW/glfw3.h>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
 #include <vector>
 #include "renderer.h"
 #include "mesh.h"
 #include "structs_vulkan.h"
 #include "camera_p.h"
+#include "frameSnapshot.h"
 
 class VulkanRenderer : public Renderer{
 public:
     /// @brief Implementation of Renderer pure virtual method
     void initialize(GLFWwindow*, int, int, std::reference_wrapper<Event<int,int>>) override;
 
-    bool render(Camera*, std::vector<Object*>) override;
+    bool render(const FrameSnapshot&) override;
 
     void cleanup() override;
 
@@ -37,6 +42,10 @@ private:
     const int MAX_OBJECT_DESCRIPTOR_SETS = 10;
     //Constant to define the maximum number of sets in the camera pool
     const int MAX_CAMERA_DESCRIPTOR_SETS = 5;
+    //Constant to define the number of slots the object buffers are first created with
+    const uint32_t INITIAL_OBJECT_CAPACITY = 1024;
+    //Constant to define the size in bytes of each frame's partition of the dynamic ring buffer
+    const VkDeviceSize DYNAMIC_RING_PARTITION_SIZE = 256 * 1024;
 
     //Control if validation layers will be used through the define of NDEBUG
     #ifndef NDEBUG
@@ -57,15 +66,21 @@ private:
 
     //Stores the Vulkan instance
     VkInstance instance;
+    //Vulkan version the instance was created with; the highest the loader supports up to 1.2
+    uint32_t instanceApiVersion = VK_API_VERSION_1_0;
 
-    //Locally stores the width and height of the window. Updated by Engine via windowResizedEvent
-    int width,height;
-    int windowResizedEventSubId;
+    //Locally stores the width and height of the window. Updated by Engine via windowResizedEvent on the main thread and read by the render thread
+    std::atomic<int> width, height;
+    //Set when the window is resized. The render thread recreates the swap chain before its next frame
+    std::atomic<bool> swapChainResized{false};
+    Event<int,int>::SubscriptionId windowResizedEventSubId;
 
     //Stores the Vulkan debug messenger instance
     VkDebugUtilsMessengerEXT debugMessenger;
     //Stores the physical device to be targeted by Vulkan; this is implicitly destroyed alongside the instance
     VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    //Capabilities of the physical device in use
+    DeviceCapabilities deviceCapabilities;
     //Stores a list of all of the queue family sets in use
     std::vector<QueueFamilyIndices> queueFamilies;
     //Stores the logical device to be used by Vulkan
@@ -78,8 +93,8 @@ private:
     VkQueue presentQueue;
     //Stores a handle the transfer queue; this is implicitly cleaned up alongside the device it's associated with
     VkQueue transferQueue;
-    //Stores the Vulkan swap chain object
-    VkSwapchainKHR swapChain;
+    //Stores the Vulkan swap chain object. Handed to the replacement as its old swap chain when recreated
+    VkSwapchainKHR swapChain = VK_NULL_HANDLE;
 
     //Stores a list of handles for each of the swap chain images
     //std::vector<VkImage> swapChainImages;
@@ -102,6 +117,33 @@ private:
     VkDescriptorSetLayout objectDescriptorSetLayout;
     //Stores the descriptor set handles from the object descriptor pool; automatically freed when objectDescriptorPool is destroyed
     std::vector<VkDescriptorSet> objectDescriptorSets;
+
+    //Stores the descriptor pool for per frame data
+    VkDescriptorPool frameDescriptorPool;
+    //Stores the descriptor set layout for shader bindings shared by every draw of a frame; eg the object buffer and view uniforms
+    VkDescriptorSetLayout frameDescriptorSetLayout;
+    //Stores a descriptor set per frame in flight; automatically freed when frameDescriptorPool is destroyed
+    std::vector<VkDescriptorSet> frameDescriptorSets;
+
+    //Per-object data as last received from the snapshots. Copies that missed writes while other frames were in flight are updated from it. Indexed by object slot
+    std::vector<ObjectGpuData> objectData;
+    //Stores a copy of the object buffer per frame in flight so writes never touch data the GPU may be reading
+    std::vector<ObjectBufferFrame> objectBufferFrames;
+    //Stores per-frame dynamic data such as the view uniforms. Partitioned by frame in flight
+    DynamicRingBuffer dynamicRing;
+    //Offset of each snapshot view's uniforms in the dynamic ring for the frame being rendered
+    std::vector<uint32_t> viewDataOffsets;
+    //Minimum alignment of uniform and storage buffer offsets on the physical device
+    VkDeviceSize uniformBufferAlignment = 1;
+    VkDeviceSize storageBufferAlignment = 1;
+
+    //True if a device local memory type is also host visible. Buffers rewritten by the CPU are placed in it so the GPU reads them from its own memory
+    bool hasHostVisibleDeviceMemory = false;
+    //True if host visible device local memory spans the largest device local heap; eg integrated GPUs, software implementations and resizable BAR.
+    //Mesh data is then written in place rather than through a staging buffer
+    bool hasUnifiedMemory = false;
+    //Memory properties of buffers rewritten by the CPU every frame
+    VkMemoryPropertyFlags dynamicMemoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
     
     //Stores the graphics pipeline layout object
     VkPipelineLayout pipelineLayout;
@@ -111,6 +153,8 @@ private:
     std::vector<VkFramebuffer> swapChainFramebuffers;
     //Stores the command pool that contains the command buffers for the family supporting the GRAPHICS type
     VkCommandPool graphicsCommandPool;
+    //Stores the command pool used for one off commands on the GRAPHICS family, kept apart from the render thread's per frame command buffers
+    VkCommandPool graphicsUploadCommandPool;
     //Stores the command pool that contains the command buffers for the family supporting the TRANSFER type
     VkCommandPool transferCommandPool;
     //Stores the command buffers for the GRAPHICS command pool; automatically freed when its command pool is destroyed
@@ -121,12 +165,29 @@ private:
     std::vector<VkSemaphore> imageAvailableSemaphores;
     //Stores the semaphore objects to signal when rendering is complete and presentation can happen
     std::vector<VkSemaphore> renderFinishedSemaphores;
-    //Stores the fence objects to signal when presentation is complete
-    std::vector<VkFence> inFlightFences;
-    //Stores the fence object used to signal when an object render batch is complete
-    VkFence renderFence;
     //Stores the current frame index; used as an index into semaphores
     uint32_t currentFrame = 0;
+    //Work submitted to the graphics and transfer queues. Share a timeline when the queues are the same
+    QueueTimeline graphicsTimeline;
+    QueueTimeline transferTimeline;
+    //Graphics timeline value signaled by the last batch of the most recent frame. Only used on the render thread
+    uint64_t lastFrameTimelineValue = 0;
+    //Number of frames whose commands have been submitted. Written by the render thread and read by unloads on the main thread
+    std::atomic<uint64_t> submittedFrameCount{0};
+    //Number of frames the GPU has finished. Only used on the render thread
+    uint64_t completedFrameCount = 0;
+
+    //Resources released by unloads, destroyed once the GPU has finished every frame submitted before their release. Ordered by frame
+    std::deque<RetiredResource> retiredResources;
+    //Guards retiredResources; unloads run on the main thread while the render thread destroys completed entries
+    std::mutex retiredResourceMutex;
+
+    //Guards queue submission, and presentation when the present queue is also submitted to; the render thread and uploads from the main thread share queues
+    std::mutex queueSubmitMutex;
+    //Guards presentation on a dedicated present queue so a blocking present doesn't hold up submissions
+    std::mutex presentMutex;
+    //Held by the caller around beginSingleTimeCommands and endSingleTimeCommands as the one off command pools are used from both threads
+    std::mutex singleTimeCommandMutex;
 
     //Stores the texture sampler handle
     VkSampler textureSampler;
@@ -134,7 +195,6 @@ private:
     //Stores depth image handles
     ImageData depthImage;
 
-    PushConstants pushConstants;
     
     std::vector<VkImage> images;
 
@@ -157,10 +217,11 @@ private:
     /// @brief Records the command buffer that will render a frame to a swap chain image
     /// @param commandBuffer Command buffer to write commands into
     /// @param imageIndex Index of the framebuffer that will be rendered to
-    /// @param viewProjMatrix Precomputed camera matrices to be used with object transformation matrix to generate MVP push constant
-    /// @param objects Pointer to entry in object array used to fetch model data
-    /// @param objectCount Number of objects to be drawn within this render command buffer. Used to increment the pointer to walk along the array
-    void recordObjectRenderCommandBuffer(VkCommandBuffer, uint32_t, glm::mat4, Object*, int);
+    /// @param viewDataOffset Offset of the view's uniforms in the dynamic ring; the dynamic offset the frame's descriptor set is bound with
+    /// @param draws Pointer to the first snapshot draw in the batch
+    /// @param drawCount Number of draws to be recorded within this render command buffer
+    /// @param ranges The snapshot's index ranges the draws refer to
+    void recordObjectRenderCommandBuffer(VkCommandBuffer, uint32_t, uint32_t, const SnapshotDraw*, int, const SnapshotRange*);
     
     /// @brief Creates the command buffers
     /// @param commandPool Reference to the command pool the buffer will be created on
@@ -189,8 +250,9 @@ private:
     /// @brief Creates an image view for each of the images within the swap chain
     void createSwapChainImageViews();
     
-    /// @brief Regenerates the swap chain
-    void recreateSwapChain();
+    /// @brief Regenerates the swap chain from the old one without idling the device. The old swap chain and its dependent objects are retired
+    /// @return Returns false if the surface has no area, eg while the window is minimized; the swap chain is left as is
+    bool recreateSwapChain();
 
     /// @brief Creates the Vulkan swap chain 
     void createSwapChain();
@@ -210,6 +272,16 @@ private:
     /// @param bufferMemory Reference to output the buffer memory handle to
     void createBuffer(VkDeviceSize, VkBufferUsageFlags, VkMemoryPropertyFlags, VkBuffer&, VkDeviceMemory&);
 
+    /// @brief Inspects the memory heaps of the physical device for device local memory the CPU can write to directly
+    void queryMemoryHeaps();
+
+    /// @brief Creates a device local buffer and fills it. Written in place when the device has unified memory, otherwise through a staging buffer and a copy
+    /// @param size The size of the buffer in bytes
+    /// @param usage Informs Vulkan of the purpose of the buffer
+    /// @param writeData Called with a mapped pointer to size bytes to write the buffer's contents into
+    /// @param output The buffer set to populate
+    void createDeviceBuffer(VkDeviceSize, VkBufferUsageFlags, const std::function<void(void*)>&, BufferSet&);
+
     /// @brief Creates a vertex buffer for use in shaders
     void createVertexBuffer(const Mesh*, MeshData*);
 
@@ -272,18 +344,112 @@ private:
     /// @return 
     bool isDeviceSuitable(VkPhysicalDevice);
     
-    /// @brief Determines which physical device should be used by Vulkan
+    /// @brief Queries the properties, features and queue families of a physical device
+    /// @param device The physical device to query
+    /// @return
+    DeviceCapabilities queryDeviceCapabilities(VkPhysicalDevice);
+
+    /// @brief Rates a physical device by type, then features, then memory. Discrete GPUs always outscore integrated, virtual and software devices
+    /// @param capabilities The capabilities of the device
+    /// @return Higher is better
+    uint64_t scoreDevice(const DeviceCapabilities&);
+
+    /// @brief Creates the timeline semaphores of the graphics and transfer queues. Without timeline semaphore support the timelines use fences instead
+    void createTimelines();
+
+    /// @brief Destroys the semaphores and fences of a timeline. The timeline's queue must be idle
+    /// @param timeline The timeline to destroy
+    void destroyTimeline(QueueTimeline&);
+
+    /// @brief Returns the timeline of the queue. Queues shared between roles share a timeline
+    /// @param queue The graphics or transfer queue
+    /// @return
+    QueueTimeline& getQueueTimeline(VkQueue);
+
+    /// @brief Submits work to a queue, signaling the next value of the queue's timeline on completion
+    /// @param timeline The timeline of the queue
+    /// @param queue The queue to submit to
+    /// @param submitInfo The work to submit. Its binary semaphores are signaled as usual
+    /// @return Returns the timeline value the submission signals
+    uint64_t submitToTimeline(QueueTimeline&, VkQueue, const VkSubmitInfo&);
+
+    /// @brief Returns true if the GPU has completed the submission that signals a timeline value, without blocking
+    /// @param timeline The timeline to query
+    /// @param value The value to check
+    /// @return
+    bool isTimelineComplete(QueueTimeline&, uint64_t);
+
+    /// @brief Blocks until the GPU has completed the submission that signals a timeline value, and every earlier submission to the queue
+    /// @param timeline The timeline to wait on
+    /// @param value The value to wait for
+    void waitTimeline(QueueTimeline&, uint64_t);
+
+    /// @brief Recycles the fences of completed submissions and advances the completed value. Only used without timeline semaphores; the timeline's mutex must be held
+    /// @param timeline The timeline to update
+    void collectCompletedFences(QueueTimeline&);
+
+    /// @brief Queues a resource for destruction once the GPU has finished every frame submitted so far
+    /// @param resource The handles to destroy
+    /// @param extraFrames Number of further frames to wait for
+    void retireResource(RetiredResource, uint64_t = 0);
+
+    /// @brief Queues a buffer for destruction once the GPU has finished every frame submitted so far
+    /// @param bufferSet The buffer and memory to destroy
+    void retireBuffer(const BufferSet&);
+
+    /// @brief Queues an image for destruction once the GPU has finished every frame submitted so far
+    /// @param imageData The image, views and memory to destroy
+    void retireImage(const ImageData&);
+
+    /// @brief Destroys the retired resources whose frames the GPU has finished. Called from the render thread
+    /// @param all If true every retired resource is destroyed. Only valid once the device is idle
+    void destroyRetiredResources(bool = false);
+
+    /// @brief Determines which physical device should be used by Vulkan; the preferred device if one is set and suitable, otherwise the highest scoring suitable device
     void pickPhysicalDevice();
 
-    /// @brief Clean up method for swap chain and related structures
+    /// @brief Clean up method for swap chain and related structures. The device must be idle
     void cleanupSwapChain();
 
+    /// @brief Queues the swap chain's frame buffers, image views and depth buffer for destruction once in flight frames complete.
+    ///     The swap chain handle itself is kept for the replacement to be created from, and destroyed a frame later as presentation isn't covered by the graphics timeline
+    void retireSwapChain();
+
     /// @brief Creates the shader binding layouts
     void createObjectDescriptorSetLayout();
-    
-    /// @brief Creates the uniform buffers used in shaders
+
+    /// @brief Creates the shader binding layout for data shared by every draw of a frame
+    void createFrameDescriptorSetLayout();
+
+    /// @brief Creates the object buffer of every frame in flight, the dynamic ring and the descriptor sets binding them
+    void createFrameDataBuffers();
+
+    /// @brief Records a snapshot's object writes in objectData and flags the written slots dirty in every frame's copy
+    /// @param snapshot The snapshot being rendered
+    void applyObjectUpdates(const FrameSnapshot&);
+
+    /// @brief Brings a frame's copy of the object buffer up to date, growing it if it can't hold every slot. The frame must not be in flight
+    /// @param frame Index of the frame in flight
+    void flushObjectBuffer(uint32_t);
+
+    /// @brief (Re)creates a frame's object buffer with room for a number of slots and points its descriptor set at it
+    /// @param frame Index of the frame in flight
+    /// @param capacity Number of slots the buffer must hold
+    void createObjectBuffer(uint32_t, uint32_t);
+
+    /// @brief Creates the dynamic ring buffer with a partition per frame in flight and maps it for its lifetime
+    void createDynamicRing();
+
+    /// @brief Copies a value into the current frame's partition of the dynamic ring
+    /// @param data The value to copy
+    /// @param alignment Required alignment of the allocation
+    /// @return Returns the offset of the copy from the start of the ring buffer
     template <typename T>
-    BufferSet createUniformBuffer();
+    VkDeviceSize writeDynamic(const T&, VkDeviceSize);
+
+    /// @brief Writes the uniforms of every view of a snapshot into the dynamic ring, filling viewDataOffsets
+    /// @param views The views of the snapshot being rendered
+    void writeViewData(const std::vector<SnapshotView>&);
 
     /// @brief Creates a pool of uniform buffer descriptors
     /// @param descriptorPool The descriptor pool variable to populate
@@ -298,7 +464,7 @@ private:
     /// @param descriptorSets The vector to resize and populate the new set handles into
     void createDescriptorSets(VkDescriptorPool, uint32_t, std::vector<VkDescriptorSetLayout>, std::vector<VkDescriptorSet>&);
 
-    void updateDescriptorSet(std::vector<VkWriteDescriptorSet>&, VkDescriptorSet&, Object*);
+    void updateDescriptorSet(std::vector<VkWriteDescriptorSet>&, VkDescriptorSet&, Material*);
 
     VkWriteDescriptorSet createDescriptorWrite(VkDescriptorSet&, int, int, VkDescriptorType, int, VkDescriptorBufferInfo* = nullptr, VkDescriptorImageInfo* = nullptr, VkBufferView* = nullptr);
 
@@ -317,7 +483,7 @@ private:
     void createImage(uint32_t, uint32_t, VkFormat, VkImageTiling, 
         VkImageUsageFlags, VkMemoryPropertyFlags, ImageData*);
 
-    /// @brief Creates a command buffer and executes a Begin command
+    /// @brief Creates a command buffer and executes a Begin command. The caller must hold singleTimeCommandMutex until endSingleTimeCommands returns
     /// @param commandPool The command pool to create the buffer in
     /// @return Returns the created command buffer
     VkCommandBuffer beginSingleTimeCommands(VkCommandPool&);
@@ -351,13 +517,6 @@ private:
     /// @brief Creates a texture sampler
     void createTextureSampler();
 
-    /// @brief Updates a buffer
-    /// @param bufferSet Reference to the buffer and device memory to be updated
-    /// @param offset The offset into the memory that the data is to be copied at
-    /// @param dataObject The data to be copied into the memory
-    template<typename T>
-    void updateBuffer(BufferSet&, uint32_t, T);
-
     /// @brief Creates texture resource for a depth buffer
     void createDepthResources();
 
@@ -396,7 +555,7 @@ private:
         const VkDebugUtilsMessengerCallbackDataEXT*,
         void*);
 
-    /// @brief Method used to respond to windowResizedEvent invocation
+    /// @brief Method used to respond to windowResizedEvent invocation. Flags the swap chain for recreation on the render thread
     /// @param  width
     /// @param  height
     void windowResizedCallback(int, int);